@@ -1,63 +1,283 @@
 #include "common.hpp"
+#include "integer_scanner.hpp"
+#include "profile.hpp"
+#include "solvers.hpp"
 
 #include <algorithm>
-#include <catch2/catch_test_macros.hpp>
+#include <array>
+#include <bit>
 #include <cstddef>
 #include <cstdint>
 #include <cstdlib>
+#include <filesystem>
 #include <fmt/format.h>
 #include <format>
+#include <fstream>
+#include <functional>
 #include <iostream>
 #include <numeric>
 #include <stdexcept>
 #include <string>
 #include <string_view>
+#include <utility>
+
+#ifdef AOC_TESTS
+#include "bench.hpp"
+#include "generators.hpp"
+#include "temp_file.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+#endif
 
 namespace r = std::ranges;
 namespace v = std::ranges::views;
 
-int64_t extractNumber(std::string_view line, bool allowWritteDigits = false)
+namespace day1
 {
-  std::size_t first_number_pos = line.size();
-  std::size_t last_number_pos = 0;
 
-  int64_t first_number = -1;
-  int64_t last_number = -1;
+struct DigitPattern
+{
+  std::string_view text;
+  int8_t value;
+};
+
+// clang-format off
+constexpr std::array<DigitPattern, 20> digitPatterns = {{
+  {"0", 0}, {"1", 1}, {"2", 2}, {"3", 3}, {"4", 4}, {"5", 5}, {"6", 6}, {"7", 7}, {"8", 8}, {"9", 9},
+  {"zero", 0}, {"one", 1}, {"two", 2}, {"three", 3}, {"four", 4}, {"five", 5}, {"six", 6}, {"seven", 7},
+  {"eight", 8}, {"nine", 9},
+}};
+// clang-format on
+
+// Enough for a trie over all pattern characters plus the root
+constexpr std::size_t maxDigitStates = 64;
+// Characters that occur in a pattern get their own class, everything else shares class 0
+constexpr std::size_t maxDigitClasses = 32;
 
-  std::string digits = "0123456789";
-  first_number_pos = std::min(first_number_pos, line.find_first_of(digits));
-  if (first_number_pos != line.size()) {
-    last_number_pos = std::max(last_number_pos, line.find_last_of(digits));
+// Aho-Corasick automaton over digitPatterns, flattened into a DFA: every state has a transition for every
+// character class, so a scan is one table lookup per character. value is the digit recognized on entering a state,
+// -1 if none.
+struct DigitAutomaton
+{
+  std::array<uint8_t, 256> charClass{};
+  std::array<std::array<uint8_t, maxDigitClasses>, maxDigitStates> next{};
+  std::array<int8_t, maxDigitStates> value{};
+
+  // Digit of the first match met walking the line front to back (or back to front), -1 if there is none
+  constexpr int find(std::string_view line, bool forward) const
+  {
+    uint8_t state = 0;
+    for (std::size_t i = 0; i < line.size(); i++) {
+      char c = forward ? line[i] : line[line.size() - 1 - i];
+      state = next[state][charClass[static_cast<unsigned char>(c)]];
+      if (value[state] >= 0) {
+        return value[state];
+      }
+    }
+    return -1;
   }
+};
+
+// Builds the automaton for the patterns read left to right, or right to left for scanning a line from its end
+constexpr DigitAutomaton buildDigitAutomaton(bool reversed)
+{
+  DigitAutomaton automaton;
+  auto patternChar = [reversed](std::string_view text, std::size_t i) {
+    return static_cast<unsigned char>(reversed ? text[text.size() - 1 - i] : text[i]);
+  };
 
-  if (first_number_pos < line.size()) {
-    first_number = line[first_number_pos] - '0';
-    last_number = line[last_number_pos] - '0';
+  std::size_t classCount = 1;
+  for (const auto& pattern : digitPatterns) {
+    for (std::size_t i = 0; i < pattern.text.size(); i++) {
+      auto c = patternChar(pattern.text, i);
+      if (automaton.charClass[c] == 0) {
+        automaton.charClass[c] = static_cast<uint8_t>(classCount++);
+      }
+    }
+  }
+  if (classCount > maxDigitClasses) {
+    throw std::logic_error("Too many character classes");
   }
 
-  if (allowWritteDigits) {
-    std::array digits = {"zero", "one", "two", "three", "four", "five", "six", "seven", "eight", "nine"};
-    for (std::size_t i = 0; i < digits.size(); i++) {
-      auto first_pos = line.find(digits[i]);
-      auto last_pos = line.rfind(digits[i]);
-
-      if (first_pos != std::string::npos && first_pos < first_number_pos) {
-        first_number_pos = first_pos;
-        first_number = static_cast<int64_t>(i);
+  // Trie, 0 marks a missing edge since the root is never a child
+  std::array<std::array<uint8_t, maxDigitClasses>, maxDigitStates> trie{};
+  automaton.value.fill(-1);
+  std::size_t stateCount = 1;
+  for (const auto& pattern : digitPatterns) {
+    std::size_t state = 0;
+    for (std::size_t i = 0; i < pattern.text.size(); i++) {
+      auto c = automaton.charClass[patternChar(pattern.text, i)];
+      if (trie[state][c] == 0) {
+        if (stateCount == maxDigitStates) {
+          throw std::logic_error("Too many automaton states");
+        }
+        trie[state][c] = static_cast<uint8_t>(stateCount++);
       }
-      if (last_pos != std::string::npos && last_pos > last_number_pos) {
-        last_number_pos = last_pos;
-        last_number = static_cast<int64_t>(i);
+      state = trie[state][c];
+    }
+    automaton.value[state] = pattern.value;
+  }
+
+  // Breadth first, so the failure state of a node is complete before its children are visited
+  std::array<uint8_t, maxDigitStates> fail{};
+  std::array<uint8_t, maxDigitStates> queue{};
+  std::size_t head = 0;
+  std::size_t tail = 0;
+  for (std::size_t c = 0; c < classCount; c++) {
+    if (auto child = trie[0][c]; child != 0) {
+      automaton.next[0][c] = child;
+      queue[tail++] = child;
+    }
+  }
+  while (head < tail) {
+    auto state = queue[head++];
+    if (automaton.value[state] < 0) {
+      automaton.value[state] = automaton.value[fail[state]];
+    }
+    for (std::size_t c = 0; c < classCount; c++) {
+      auto fallback = automaton.next[fail[state]][c];
+      if (auto child = trie[state][c]; child != 0) {
+        fail[child] = fallback;
+        automaton.next[state][c] = child;
+        queue[tail++] = child;
+      } else {
+        automaton.next[state][c] = fallback;
       }
     }
   }
+  return automaton;
+}
+
+// The first match to end is only the first to start if no pattern lies inside another one
+constexpr bool noNestedDigitPatterns()
+{
+  for (const auto& outer : digitPatterns) {
+    for (const auto& inner : digitPatterns) {
+      if (&outer != &inner && outer.text.find(inner.text) != std::string_view::npos) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+static_assert(noNestedDigitPatterns());
+
+constexpr DigitAutomaton forwardDigits = buildDigitAutomaton(false);
+constexpr DigitAutomaton backwardDigits = buildDigitAutomaton(true);
+
+constexpr bool isDigit(char c)
+{
+  return c >= '0' && c <= '9';
+}
+
+// Scans from the front up to the first digit and from the back up to the last one, written digits ("one") count
+// as well if allowWritteDigits is set
+constexpr int64_t extractNumber(std::string_view line, bool allowWritteDigits = false)
+{
+  int64_t first_number = -1;
+  int64_t last_number = -1;
+
+  if (allowWritteDigits) {
+    first_number = forwardDigits.find(line, true);
+    last_number = backwardDigits.find(line, false);
+  } else if (auto first = r::find_if(line, isDigit); first != line.end()) {
+    first_number = *first - '0';
+    last_number = *r::find_if(line | v::reverse, isDigit) - '0';
+  }
 
-  if (first_number_pos >= line.size()) {
+  if (first_number < 0) {
     throw std::runtime_error("Invalid input no digit found!");
   }
 
   return (10 * first_number) + last_number;
 }
+static_assert(extractNumber("xtwone3four", true) == 24);
+static_assert(extractNumber("zoneight234", true) == 14);
+
+// Task1 straight on the raw input: digits and newlines are classified 64 bytes at a time (AVX2, SSE2 or scalar, see
+// integer_scanner.hpp) and the first and last digit of every line are read off the masks without ever
+// materializing a line. Like extractNumber it throws for a line without digits.
+inline int64_t sumFirstLastDigits(std::string_view text)
+{
+  const char* data = text.data();
+  int64_t sum{};
+  int64_t first = -1;
+  int64_t last = -1;
+
+  auto takeDigits = [&](std::size_t base, uint64_t digits) {
+    if (digits != 0) {
+      if (first < 0) {
+        first = data[base + static_cast<std::size_t>(std::countr_zero(digits))] - '0';
+      }
+      last = data[base + 63 - static_cast<std::size_t>(std::countl_zero(digits))] - '0';
+    }
+  };
+  auto endLine = [&] {
+    if (first < 0) {
+      throw std::runtime_error("Invalid input no digit found!");
+    }
+    sum += (10 * first) + last;
+    first = -1;
+  };
+
+  for (std::size_t base = 0; base < text.size(); base += 64) {
+    auto count = std::min<std::size_t>(64, text.size() - base);
+    uint64_t digits = scanner_detail::digitMask(data + base, count);
+    uint64_t newlines = scanner_detail::byteMask(data + base, count, '\n');
+    while (newlines != 0) {
+      uint64_t before = (uint64_t{1} << std::countr_zero(newlines)) - 1;
+      takeDigits(base, digits & before);
+      endLine();
+      digits &= ~before;
+      newlines &= newlines - 1;
+    }
+    // The rest of the block belongs to a line continuing in the next one
+    takeDigits(base, digits);
+  }
+  if (!text.empty() && text.back() != '\n') {
+    endLine();
+  }
+  return sum;
+}
+
+// Bytes per piece of the parallel task1 kernel
+constexpr std::size_t task1PieceSize = 256 * 1024;
+
+// Single pass over the input with constant memory
+std::pair<int64_t, int64_t> solveStreaming(const std::filesystem::path& path,
+                                           std::size_t bufferSize = LineStream::defaultBufferSize)
+{
+  std::pair<int64_t, int64_t> result{};
+  forEachLine(
+      path,
+      [&result](std::string_view line) {
+        result.first += extractNumber(line);
+        result.second += extractNumber(line, true);
+      },
+      bufferSize);
+  return result;
+}
+
+// Entry point of the aoc runner
+Answers solve(const MappedInput& input, TaskSelection tasks)
+{
+  Answers answers;
+  if (tasks.task1) {
+    AOC_PROFILE_ZONE("task1");
+    answers.task1 = parallelTransformReduce(splitIntoLineChunks(input.data(), task1PieceSize), int64_t{0},
+                                            std::plus<>{}, sumFirstLastDigits, 1);
+  }
+  if (tasks.task2) {
+    AOC_PROFILE_ZONE("task2");
+    answers.task2 = parallelTransformReduce(input.lines(), int64_t{0}, std::plus<>{},
+                                            [](std::string_view line) { return extractNumber(line, true); });
+  }
+  return answers;
+}
+}  // namespace day1
+
+#ifdef AOC_TESTS
+using namespace day1;
 
 TEST_CASE("Inputs Task1")
 {
@@ -78,29 +298,128 @@ TEST_CASE("Inputs Task2")
   REQUIRE(extractNumber("7pqrstsixteen", true) == 76);
 }
 
-TEST_CASE("Task1")
+TEST_CASE("Automaton matches searching every pattern")
 {
-  auto inputLines = readLines("../../day1/input.txt");
-  REQUIRE(inputLines.size() == 1000);
-  REQUIRE(inputLines.front() == "cmpptgjc3qhcjxcbcqgqkxhrms");
-  REQUIRE(inputLines.back() == "sixeightfive3sdtwo");
+  auto naive = [](std::string_view line) {
+    std::size_t firstPos = line.size();
+    std::size_t lastPos = 0;
+    int64_t first = -1;
+    int64_t last = -1;
+    for (const auto& pattern : digitPatterns) {
+      if (auto pos = line.find(pattern.text); pos != std::string_view::npos && pos < firstPos) {
+        firstPos = pos;
+        first = pattern.value;
+      }
+      if (auto pos = line.rfind(pattern.text); pos != std::string_view::npos && (last < 0 || pos > lastPos)) {
+        lastPos = pos;
+        last = pattern.value;
+      }
+    }
+    return (10 * first) + last;
+  };
+
+  auto text = generateToString(
+      [](std::ostream& out) { generateDay1(out, {.lines = 2000, .digitRatio = 0.05, .writtenDigitRatio = 0.2}, 5); });
+  for (auto line : splitLines(text)) {
+    REQUIRE(extractNumber(line, true) == naive(line));
+  }
+  REQUIRE(extractNumber("zerone", true) == 1);
+  REQUIRE(extractNumber("5zero", true) == 50);
+}
+
+TEST_CASE("Task1 kernel matches extractNumber")
+{
+  // Lines shorter and longer than a 64 byte block, with and without a trailing newline
+  for (std::size_t maxLength : {8, 40, 200}) {
+    auto text = generateToString([maxLength](std::ostream& out) {
+      generateDay1(out, {.lines = 3000, .minLength = 1, .maxLength = maxLength, .digitRatio = 0.05}, maxLength);
+    });
+    int64_t expected{};
+    for (auto line : splitLines(text)) {
+      expected += extractNumber(line);
+    }
+    REQUIRE(sumFirstLastDigits(text) == expected);
+    text.pop_back();
+    REQUIRE(sumFirstLastDigits(text) == expected);
+
+    auto pieces = splitIntoLineChunks(text, 1000);
+    int64_t sum{};
+    for (std::size_t i = 0; i < pieces.size(); i++) {
+      REQUIRE((i + 1 == pieces.size() || pieces[i].back() == '\n'));
+      sum += sumFirstLastDigits(pieces[i]);
+    }
+    REQUIRE(sum == expected);
+  }
+  REQUIRE_THROWS_AS(sumFirstLastDigits("1a\n\n2b\n"), std::runtime_error);
+  REQUIRE_THROWS_AS(sumFirstLastDigits("1a\nb"), std::runtime_error);
+}
 
-  int64_t result = std::accumulate(inputLines.begin(), inputLines.end(), static_cast<int64_t>(0),
-                                   [](int64_t sum, const std::string& line) { return sum + extractNumber(line); });
+TEST_CASE("Streaming with small buffer")
+{
+  TempFile file("aoc_day1_stream_test");
+  {
+    std::ofstream out(file.path());
+    out << "two1nine\neightwo3three\nabcone2threexyz\nxtwone3four\n4nineeightseven2\nzoneight234\n7pqrstsixteen";
+  }
 
-  std::cout << std::format("Day1 Task1 result: {}\n", result);
+  // Buffer smaller than a line forces refills and buffer growth
+  auto [task1, task2] = solveStreaming(file.path(), 4);
+  REQUIRE(task1 == 242);
+  REQUIRE(task2 == 281);
 }
 
-TEST_CASE("Task2")
+TEST_CASE("Parallel solve")
 {
-  auto inputLines = readLines("../../day1/input.txt");
+  // Many chunks, so the work stealing pool gets involved
+  auto text = generateToString([](std::ostream& out) { generateDay1(out, {.lines = 20000}, 3); });
+  MappedInput input(std::vector<char>(text.begin(), text.end()));
+  int64_t task1{};
+  int64_t task2{};
+  for (auto line : input) {
+    task1 += extractNumber(line);
+    task2 += extractNumber(line, true);
+  }
+  auto answers = solve(input, {});
+  REQUIRE(answers.task1 == task1);
+  REQUIRE(answers.task2 == task2);
+
+  // A bad line in some chunk surfaces on the calling thread
+  text.insert(text.size() / 2, "\nnodigits\n");
+  MappedInput broken(std::vector<char>(text.begin(), text.end()));
+  REQUIRE_THROWS_AS(solve(broken, {}), std::runtime_error);
+}
+
+TEST_CASE("Tasks")
+{
+  MappedInput inputLines("../../day1/input.txt");
   REQUIRE(inputLines.size() == 1000);
   REQUIRE(inputLines.front() == "cmpptgjc3qhcjxcbcqgqkxhrms");
   REQUIRE(inputLines.back() == "sixeightfive3sdtwo");
 
-  int64_t result =
-      std::accumulate(inputLines.begin(), inputLines.end(), static_cast<int64_t>(0),
-                      [](int64_t sum, const std::string& line) { return sum + extractNumber(line, true); });
+  auto [task1, task2] = solveStreaming("../../day1/input.txt");
+  auto answers = solve(inputLines, {});
+  REQUIRE(answers.task1 == task1);
+  REQUIRE(answers.task2 == task2);
 
-  std::cout << std::format("Day1 Task2 result: {}\n", result);
+  std::cout << std::format("Day1 Task1 result: {}\n", task1);
+  std::cout << std::format("Day1 Task2 result: {}\n", task2);
+}
+
+TEST_CASE("Benchmark", "[.benchmark]")
+{
+  const std::filesystem::path path = benchmarkInputPath("day1");
+  MappedInput input(path);
+  Benchmark bench("day1", input);
+  bench.run("read", [&] { return MappedInput(path); });
+  bench.run("task1", [&] {
+    return std::accumulate(input.begin(), input.end(), static_cast<int64_t>(0),
+                           [](int64_t sum, std::string_view line) { return sum + extractNumber(line); });
+  });
+  bench.run("task1 kernel", [&] { return sumFirstLastDigits(input.data()); });
+  bench.run("task2", [&] {
+    return std::accumulate(input.begin(), input.end(), static_cast<int64_t>(0),
+                           [](int64_t sum, std::string_view line) { return sum + extractNumber(line, true); });
+  });
+  bench.run("stream", [&] { return solveStreaming(path); });
 }
+#endif  // AOC_TESTS
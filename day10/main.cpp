@@ -1,6 +1,9 @@
 #include "common.hpp"
+#include "grid2d.hpp"
+#include "profile.hpp"
+#include "solvers.hpp"
 
-#include <catch2/catch_test_macros.hpp>
+#include <filesystem>
 #include <fmt/core.h>
 #include <fmt/format.h>
 #include <optional>
@@ -10,11 +13,21 @@
 #include <stack>
 #include <stdexcept>
 #include <string>
+#include <utility>
 #include <vector>
 
+#ifdef AOC_TESTS
+#include "bench.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+#endif
+
 namespace r = std::ranges;
 namespace v = std::ranges::views;
 
+namespace day10
+{
+
 struct Position
 {
   int x;
@@ -34,40 +47,44 @@ struct Pipe
   bool startPosition{false};
 };
 
-std::vector<std::vector<Pipe>> parseField(const std::vector<std::string>& input)
+Pipe pipeFromChar(char c)
 {
-  return toVector(input | v::transform([](const std::string& line) {
-                    return toVector(line | v::transform([](char c) {
-                                      switch (c) {
-                                      case '.':
-                                        return Pipe{};
-                                      case '|':
-                                        return Pipe{.e1{0, -1}, .e2{0, 1}};
-                                      case '-':
-                                        return Pipe{.e1{1, 0}, .e2{-1, 0}};
-                                      case 'L':
-                                        return Pipe{.e1{0, -1}, .e2{1, 0}};
-                                      case 'J':
-                                        return Pipe{.e1{0, -1}, .e2{-1, 0}};
-                                      case '7':
-                                        return Pipe{.e1{0, 1}, .e2{-1, 0}};
-                                      case 'F':
-                                        return Pipe{.e1{0, 1}, .e2{1, 0}};
-                                      case 'S':
-                                        return Pipe{.e1{}, .e2{}, .startPosition = true};
-                                      default:
-                                        throw std::runtime_error("Invalid pipe character!");
-                                      }
-                                    }));
-                  }));
+  switch (c) {
+  case '.':
+    return Pipe{};
+  case '|':
+    return Pipe{.e1{0, -1}, .e2{0, 1}};
+  case '-':
+    return Pipe{.e1{1, 0}, .e2{-1, 0}};
+  case 'L':
+    return Pipe{.e1{0, -1}, .e2{1, 0}};
+  case 'J':
+    return Pipe{.e1{0, -1}, .e2{-1, 0}};
+  case '7':
+    return Pipe{.e1{0, 1}, .e2{-1, 0}};
+  case 'F':
+    return Pipe{.e1{0, 1}, .e2{1, 0}};
+  case 'S':
+    return Pipe{.e1{}, .e2{}, .startPosition = true};
+  default:
+    throw std::runtime_error("Invalid pipe character!");
+  }
+}
+
+// Surrounded by ground, so stepping off the field finds an unconnected pipe instead of needing bounds checks
+using Field = Grid2D<Pipe>;
+
+Field parseField(Lines input)
+{
+  return Field::fromLines(input, 1, Pipe{}, pipeFromChar);
 }
 
-int64_t task1(const std::vector<std::vector<Pipe>> pipes)
+int64_t task1(const Field& pipes)
 {
   Position startPosition{-1, -1};
-  for (int x = 0; x < static_cast<int>(pipes.size()); x++) {
-    for (int y = 0; y < static_cast<int>(pipes.size()); y++) {
-      if (pipes[y][x].startPosition) {
+  for (int y = 0; y < static_cast<int>(pipes.height()); y++) {
+    for (int x = 0; x < static_cast<int>(pipes.width()); x++) {
+      if (pipes(x, y).startPosition) {
         startPosition = {x, y};
       }
     }
@@ -77,11 +94,8 @@ int64_t task1(const std::vector<std::vector<Pipe>> pipes)
     throw std::runtime_error("Could not find start position?");
   }
 
-  // Assumes all rows same length
-  std::vector<std::vector<int>> distances =
-      toVector(pipes | v::transform([](const auto& row) { return std::vector<int>(row.size(), -1); }));
-
-  distances[startPosition.y][startPosition.x] = 0;
+  Grid2D<int> distances(pipes.width(), pipes.height(), -1);
+  distances(startPosition.x, startPosition.y) = 0;
 
   std::queue<Position> searchStack;
   searchStack.push(startPosition);
@@ -97,7 +111,7 @@ int64_t task1(const std::vector<std::vector<Pipe>> pipes)
   while (!searchStack.empty()) {
     Position c = searchStack.front();
     searchStack.pop();
-    int newDistance = distances[c.y][c.x] + 1;
+    int newDistance = distances(c.x, c.y) + 1;
 
     auto markPosition = [&pipes, &searchStack, &distances, printField, newDistance](Position p, Position offset) {
       Position target = p + offset;
@@ -105,21 +119,16 @@ int64_t task1(const std::vector<std::vector<Pipe>> pipes)
       if (target == p) {
         return false;
       }
-      // Check if target is valid
-      if (target.y < 0 || target.y >= static_cast<int>(pipes.size()) || target.x < 0 ||
-          target.x >= static_cast<int>(pipes[target.y].size())) {
-        return false;
-      }
-
-      Pipe newPipe = pipes[target.y][target.x];
+      // Border cells are ground and never connected, so target is inside the field past this check
+      Pipe newPipe = pipes(target.x, target.y);
       // Check if connected
       if (target + newPipe.e1 != p && target + newPipe.e2 != p) {
         return false;
       }
 
-      if (distances[target.y][target.x] != -1) {
+      if (distances(target.x, target.y) != -1) {
         // Loop?
-        if (distances[target.y][target.x] == newDistance) {
+        if (distances(target.x, target.y) == newDistance) {
           printField();
           return true;
         }
@@ -128,7 +137,7 @@ int64_t task1(const std::vector<std::vector<Pipe>> pipes)
 
       // Check if pipe has connection
       searchStack.push(target);
-      distances[target.y][target.x] = newDistance;
+      distances(target.x, target.y) = newDistance;
       return false;
     };
 
@@ -146,7 +155,7 @@ int64_t task1(const std::vector<std::vector<Pipe>> pipes)
         return newDistance;
       }
     } else {
-      auto p = pipes[c.y][c.x];
+      auto p = pipes(c.x, c.y);
       if (p.e1 != Position{0, 0}) {
         if (markPosition(c, p.e1)) {
           return newDistance;
@@ -162,10 +171,30 @@ int64_t task1(const std::vector<std::vector<Pipe>> pipes)
   return 0;
 }
 
+// Entry point of the aoc runner
+Answers solve(const MappedInput& input, TaskSelection tasks)
+{
+  Answers answers;
+  if (tasks.task1) {
+    auto field = [&input] {
+      AOC_PROFILE_ZONE("parse");
+      return parseField(input.lines());
+    }();
+    AOC_PROFILE_ZONE("task1");
+    answers.task1 = task1(field);
+  }
+  // Task2 is not solved yet
+  return answers;
+}
+}  // namespace day10
+
+#ifdef AOC_TESTS
+using namespace day10;
+
 TEST_CASE("Task1 and 2 example input")
 {
   // clang-format off
-  std::vector<std::string> input = {
+  std::vector<std::string_view> input = {
     ".....",
     ".S-7.",
     ".|.|.",
@@ -200,8 +229,19 @@ TEST_CASE("Task1 and 2 example input")
 
 TEST_CASE("Tasks")
 {
-  auto input = readLines("../../day10/input.txt");
-  auto field = parseField(input);
+  MappedInput input("../../day10/input.txt");
+  auto field = parseField(input.lines());
   fmt::println("Day10 Task1 result: {}\n", task1(field));
   // fmt::println("Day10 Task2 result: {}\n", task2(sequences));
 }
+
+TEST_CASE("Benchmark", "[.benchmark]")
+{
+  const std::filesystem::path path = benchmarkInputPath("day10");
+  MappedInput input(path);
+  Benchmark bench("day10", input);
+  bench.run("read", [&] { return MappedInput(path); });
+  auto field = bench.run("parse", [&] { return parseField(input.lines()); });
+  bench.run("task1", [&] { return task1(field); });
+}
+#endif  // AOC_TESTS
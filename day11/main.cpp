@@ -1,9 +1,12 @@
 #include "common.hpp"
+#include "grid2d.hpp"
+#include "profile.hpp"
+#include "solvers.hpp"
 
 #include <algorithm>
-#include <catch2/catch_test_macros.hpp>
 #include <cstdint>
 #include <cstdlib>
+#include <filesystem>
 #include <fmt/core.h>
 #include <fmt/format.h>
 #include <iterator>
@@ -14,9 +17,18 @@
 #include <string>
 #include <vector>
 
+#ifdef AOC_TESTS
+#include "bench.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+#endif
+
 namespace r = std::ranges;
 namespace v = std::ranges::views;
 
+namespace day11
+{
+
 struct Position
 {
   int x;
@@ -64,21 +76,20 @@ struct Position
 // }
 
 using ExpandedColsAndRows = std::array<std::set<std::size_t>, 2>;
-ExpandedColsAndRows expandedColsAndRows(const std::vector<std::string>& map)
+ExpandedColsAndRows expandedColsAndRows(const CharGrid& map)
 {
   ExpandedColsAndRows result;
 
-  std::vector<std::string> expanded;
-  std::vector<bool> colContainsGalaxy(map[0].size(), false);
-  expanded.reserve(map.size());
-  // Expand rows
-  for (std::size_t y = 0; y < map.size(); y++) {
-    if (r::find(map[y], '#') == map[y].end()) {
+  // Row by row, the column flags are collected along instead of walking the columns
+  std::vector<bool> colContainsGalaxy(map.width(), false);
+  for (std::size_t y = 0; y < map.height(); y++) {
+    auto row = map.row(y);
+    if (r::find(row, '#') == row.end()) {
       result[0].insert(y);
     }
 
-    for (std::size_t x = 0; x < map[y].size(); x++) {
-      if (map[y][x] == '#') {
+    for (std::size_t x = 0; x < row.size(); x++) {
+      if (row[x] == '#') {
         colContainsGalaxy[x] = true;
       }
     }
@@ -93,12 +104,13 @@ ExpandedColsAndRows expandedColsAndRows(const std::vector<std::string>& map)
   return result;
 }
 
-std::vector<Position> getGalaxyLocations(const std::vector<std::string>& map)
+std::vector<Position> getGalaxyLocations(const CharGrid& map)
 {
   std::vector<Position> galaxies;
-  for (std::size_t y = 0; y < map.size(); y++) {
-    for (std::size_t x = 0; x < map[y].size(); x++) {
-      if (map[y][x] == '#') {
+  for (std::size_t y = 0; y < map.height(); y++) {
+    auto row = map.row(y);
+    for (std::size_t x = 0; x < row.size(); x++) {
+      if (row[x] == '#') {
         galaxies.push_back({static_cast<int>(x), static_cast<int>(y)});
       }
     }
@@ -124,7 +136,7 @@ int64_t shortestPath(Position start, Position end, const ExpandedColsAndRows& ex
   return static_cast<int64_t>(x_diff + y_diff);
 }
 
-int64_t task(const std::vector<std::string>& map, int64_t factor)
+int64_t task(const CharGrid& map, int64_t factor)
 {
   auto expandedMap = expandedColsAndRows(map);
   auto galaxies = getGalaxyLocations(map);
@@ -140,10 +152,34 @@ int64_t task(const std::vector<std::string>& map, int64_t factor)
   return sumShortedPaths;
 }
 
+// Entry point of the aoc runner
+Answers solve(const MappedInput& input, TaskSelection tasks)
+{
+  Answers answers;
+  // A view into the mapped input, nothing is copied
+  auto map = [&input] {
+    AOC_PROFILE_ZONE("parse");
+    return charGrid(input);
+  }();
+  if (tasks.task1) {
+    AOC_PROFILE_ZONE("task1");
+    answers.task1 = task(map, 1);
+  }
+  if (tasks.task2) {
+    AOC_PROFILE_ZONE("task2");
+    answers.task2 = task(map, 999999);
+  }
+  return answers;
+}
+}  // namespace day11
+
+#ifdef AOC_TESTS
+using namespace day11;
+
 TEST_CASE("Task1 and 2 example input")
 {
   // clang-format off
-  std::vector<std::string> input = {
+  std::vector<std::string_view> input = {
     "...#......",
     ".......#..",
     "#.........",
@@ -171,17 +207,32 @@ TEST_CASE("Task1 and 2 example input")
   //   "#....#.......",
   //       });
 
-  REQUIRE(getGalaxyLocations(input).size() == 9);
   // clang-format on
-  REQUIRE(task(input, 1) == 374);
-  REQUIRE(task(input, 9) == 1030);
-  REQUIRE(task(input, 99) == 8410);
+  auto map = charGrid(input);
+  REQUIRE(getGalaxyLocations(map).size() == 9);
+  REQUIRE(task(map, 1) == 374);
+  REQUIRE(task(map, 9) == 1030);
+  REQUIRE(task(map, 99) == 8410);
 }
 
 TEST_CASE("Tasks")
 {
-  auto input = readLines("../../day11/input.txt");
+  MappedInput input("../../day11/input.txt");
+  auto map = charGrid(input);
+  REQUIRE(map.isView());
 
-  fmt::println("Day11 Task1 result: {}\n", task(input, 1));
-  fmt::println("Day11 Task2 result: {}\n", task(input, 999999));
+  fmt::println("Day11 Task1 result: {}\n", task(map, 1));
+  fmt::println("Day11 Task2 result: {}\n", task(map, 999999));
+}
+
+TEST_CASE("Benchmark", "[.benchmark]")
+{
+  const std::filesystem::path path = benchmarkInputPath("day11");
+  MappedInput input(path);
+  Benchmark bench("day11", input);
+  bench.run("read", [&] { return MappedInput(path); });
+  auto map = charGrid(input);
+  bench.run("task1", [&] { return task(map, 1); });
+  bench.run("task2", [&] { return task(map, 999999); });
 }
+#endif  // AOC_TESTS
@@ -1,21 +1,34 @@
 #include "common.hpp"
+#include "profile.hpp"
+#include "solvers.hpp"
 
 #include <algorithm>
-#include <catch2/catch_test_macros.hpp>
 #include <cstdint>
+#include <filesystem>
 #include <fmt/core.h>
 #include <fmt/format.h>
+#include <functional>
 #include <map>
 #include <numeric>
 #include <ranges>
 #include <scn/scan.h>
 #include <string>
 #include <string_view>
+#include <utility>
 #include <vector>
 
+#ifdef AOC_TESTS
+#include "bench.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+#endif
+
 namespace r = std::ranges;
 namespace v = std::ranges::views;
 
+namespace day12
+{
+
 constexpr char OPERATIONAL = '.';
 constexpr char DAMAGED = '#';
 // constexpr char UNKNOWN = '?';
@@ -68,8 +81,9 @@ std::size_t getArrangementCount(Cache& cache, const std::string_view& map, const
   return total;
 }
 
-std::size_t getArrangementCount(const std::string& row, int repeat = 0)
+std::size_t getArrangementCount(std::string_view row, int repeat = 0)
 {
+  AOC_PROFILE_FUNCTION();
   auto split = row | v::split(' ') | v::transform([](auto&& rng) { return std::string(rng.begin(), rng.end()); });
   std::string map = *split.begin();
   std::string rangesStr = *(split | v::drop(1)).begin();
@@ -94,22 +108,57 @@ std::size_t getArrangementCount(const std::string& row, int repeat = 0)
   return getArrangementCount(cache, map, ranges);
 }
 
-int64_t task1(const std::vector<std::string>& lines)
+// A row costs far more than handing out a chunk, small chunks keep the cores evenly loaded
+constexpr std::size_t rowsPerChunk = 4;
+
+int64_t task1(Lines lines)
+{
+  return parallelTransformReduce(
+      lines, int64_t{0}, std::plus<>{},
+      [](std::string_view row) { return static_cast<int64_t>(getArrangementCount(row)); }, rowsPerChunk);
+}
+
+int64_t task2(Lines lines)
 {
-  return std::accumulate(lines.begin(), lines.end(), static_cast<int64_t>(0),
-                         [](auto previous, const auto& row) { return previous + getArrangementCount(row); });
+  return parallelTransformReduce(
+      lines, int64_t{0}, std::plus<>{},
+      [](std::string_view row) { return static_cast<int64_t>(getArrangementCount(row, 4)); }, rowsPerChunk);
 }
 
-int64_t task2(const std::vector<std::string>& lines)
+// Single pass over the input with constant memory
+std::pair<int64_t, int64_t> solveStreaming(const std::filesystem::path& path)
 {
-  return std::accumulate(lines.begin(), lines.end(), static_cast<int64_t>(0),
-                         [](auto previous, const auto& row) { return previous + getArrangementCount(row, 4); });
+  std::pair<int64_t, int64_t> result{};
+  forEachLine(path, [&result](std::string_view row) {
+    result.first += static_cast<int64_t>(getArrangementCount(row));
+    result.second += static_cast<int64_t>(getArrangementCount(row, 4));
+  });
+  return result;
 }
 
+// Entry point of the aoc runner
+Answers solve(const MappedInput& input, TaskSelection tasks)
+{
+  Answers answers;
+  if (tasks.task1) {
+    AOC_PROFILE_ZONE("task1");
+    answers.task1 = task1(input.lines());
+  }
+  if (tasks.task2) {
+    AOC_PROFILE_ZONE("task2");
+    answers.task2 = task2(input.lines());
+  }
+  return answers;
+}
+}  // namespace day12
+
+#ifdef AOC_TESTS
+using namespace day12;
+
 TEST_CASE("Task1 and 2 example input")
 {
   // clang-format off
-  std::vector<std::string> input = {
+  std::vector<std::string_view> input = {
     "???.### 1,1,3",
     ".??..??...?##. 1,1,3",
     "?#?#?#?#?#?#?#? 1,3,1,6",
@@ -138,8 +187,20 @@ TEST_CASE("Task1 and 2 example input")
 
 TEST_CASE("Tasks")
 {
-  auto input = readLines("../../day12/input.txt");
+  auto [task1, task2] = solveStreaming("../../day12/input.txt");
   //
-  fmt::println("Day11 Task1 result: {}\n", task1(input));
-  fmt::println("Day11 Task2 result: {}\n", task2(input));
+  fmt::println("Day11 Task1 result: {}\n", task1);
+  fmt::println("Day11 Task2 result: {}\n", task2);
+}
+
+TEST_CASE("Benchmark", "[.benchmark]")
+{
+  const std::filesystem::path path = benchmarkInputPath("day12");
+  MappedInput input(path);
+  Benchmark bench("day12", input);
+  bench.run("read", [&] { return MappedInput(path); });
+  bench.run("task1", [&] { return task1(input.lines()); });
+  bench.run("task2", [&] { return task2(input.lines()); });
+  bench.run("stream", [&] { return solveStreaming(path); });
 }
+#endif  // AOC_TESTS
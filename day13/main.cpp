@@ -1,165 +1,153 @@
 #include "common.hpp"
+#include "grid2d.hpp"
+#include "profile.hpp"
+#include "solvers.hpp"
 
 #include <algorithm>
-#include <catch2/catch_test_macros.hpp>
 #include <cstddef>
 #include <cstdint>
+#include <filesystem>
 #include <fmt/core.h>
 #include <fmt/format.h>
+#include <fstream>
+#include <functional>
+#include <numeric>
 #include <ranges>
 #include <scn/scan.h>
 #include <stdexcept>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 
+#ifdef AOC_TESTS
+#include "bench.hpp"
+#include "generators.hpp"
+#include "temp_file.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+#endif
+
 namespace r = std::ranges;
 namespace v = std::ranges::views;
 
-std::tuple<int, int> fiendReflections(const std::vector<std::string>& field)
+namespace day13
 {
-  if (field.empty())
-    throw std::runtime_error("Empty line?");
 
-  std::tuple<int, int> reflectionColAndRow{0, 0};
-  // Rows
-  for (std::size_t i = 1; i < field.size(); i++) {
-    auto leftIndices = v::iota(static_cast<std::size_t>(0), i) | v::reverse;
-    auto rightIndices = v::iota(i, field.size());
-
-    auto minLen = std::min(leftIndices.size(), rightIndices.size());
-
-    auto left = leftIndices | v::take(minLen) | v::transform([&](std::size_t row) { return field[row]; });
-    auto right = rightIndices | v::take(minLen) | v::transform([&](std::size_t row) { return field[row]; });
-
-    if (!r::equal(left, right)) {
-      continue;
+// First row i with exactly `smudges` differing cells between the rows above i and their mirror images below,
+// 0 if there is none
+template<class T>
+int reflectionRow(const Grid2D<T>& field, std::size_t smudges)
+{
+  for (std::size_t i = 1; i < field.height(); i++) {
+    auto reflLen = std::min(i, field.height() - i);
+    std::size_t diffCount{};
+    for (std::size_t k = 0; k < reflLen && diffCount <= smudges; k++) {
+      auto left = field.row(i - 1 - k);
+      auto right = field.row(i + k);
+      diffCount += static_cast<std::size_t>(
+          std::transform_reduce(left.begin(), left.end(), right.begin(), std::ptrdiff_t{0}, std::plus<>{},
+                                [](char l, char r) { return static_cast<std::ptrdiff_t>(l != r); }));
     }
-    std::get<1>(reflectionColAndRow) = static_cast<int>(i);
-    break;
-  }
-
-  // Cols
-  for (std::size_t i = 1; i < field[0].size(); i++) {
-    auto col = [&](std::size_t colIndex) {
-      auto colView = field | v::transform([colIndex](const std::string& r) { return r[colIndex]; });
-      return std::string(colView.begin(), colView.end());
-    };
-
-    auto reflLen = std::min(i, field[0].size() - i);
-    auto side1 = v::iota(static_cast<std::size_t>(0), i) | v::transform(col) | v::reverse | v::take(reflLen);
-    auto side2 = v::iota(i, field[0].size()) | v::transform(col) | v::take(reflLen);
-
-    if (!r::equal(side1, side2)) {
-      continue;
+    if (diffCount == smudges) {
+      return static_cast<int>(i);
     }
-    std::get<0>(reflectionColAndRow) = static_cast<int>(i);
-    break;
   }
-
-  if (reflectionColAndRow == std::tuple(0, 0))
-    throw std::runtime_error("No reflection found?");
-  return reflectionColAndRow;
+  return 0;
 }
 
-std::tuple<int, int> fiendReflectionsWithSmudges(const std::vector<std::string>& field)
+// Columns are compared as rows of the transposed field, which keeps every comparison on contiguous memory
+std::tuple<int, int> findReflections(const CharGrid& field, std::size_t smudges)
 {
-  if (field.empty())
+  if (field.height() == 0)
     throw std::runtime_error("Empty line?");
 
-  std::tuple<int, int> reflectionColAndRow{0, 0};
-  // Rows
-  for (std::size_t i = 1; i < field.size(); i++) {
-    auto leftIndices = v::iota(static_cast<std::size_t>(0), i) | v::reverse;
-    auto rightIndices = v::iota(i, field.size());
-
-    auto minLen = std::min(leftIndices.size(), rightIndices.size());
-
-    auto left = leftIndices | v::take(minLen) | v::transform([&](std::size_t row) { return field[row]; });
-    auto right = rightIndices | v::take(minLen) | v::transform([&](std::size_t row) { return field[row]; });
-
-    std::size_t diffCount{};
-    r::for_each(v::zip(left, right), [&diffCount](auto leftRight) {
-      auto [left, right] = leftRight;
-      for (auto [l, r] : v::zip(left, right)) {
-        if (l != r) {
-          diffCount++;
-        }
-      }
-    });
-
-    if (diffCount != 1) {
-      continue;
-    }
-
-    std::get<1>(reflectionColAndRow) = static_cast<int>(i);
-    break;
-  }
-
-  // Cols
-  for (std::size_t i = 1; i < field[0].size(); i++) {
-    auto col = [&](std::size_t colIndex) {
-      auto colView = field | v::transform([colIndex](const std::string& r) { return r[colIndex]; });
-      return std::string(colView.begin(), colView.end());
-    };
-
-    auto reflLen = std::min(i, field[0].size() - i);
-    auto left = v::iota(static_cast<std::size_t>(0), i) | v::transform(col) | v::reverse | v::take(reflLen);
-    auto right = v::iota(i, field[0].size()) | v::transform(col) | v::take(reflLen);
-
-    std::size_t diffCount{};
-    r::for_each(v::zip(left, right), [&diffCount](auto leftRight) {
-      auto [left, right] = leftRight;
-      for (auto [l, r] : v::zip(left, right)) {
-        if (l != r) {
-          diffCount++;
-        }
-      }
-    });
-
-    if (diffCount != 1) {
-      continue;
-    }
-    std::get<0>(reflectionColAndRow) = static_cast<int>(i);
-    break;
-  }
+  std::tuple<int, int> reflectionColAndRow{reflectionRow(field.transposed(), smudges), reflectionRow(field, smudges)};
 
   if (reflectionColAndRow == std::tuple(0, 0))
     throw std::runtime_error("No reflection found?");
   return reflectionColAndRow;
 }
 
-int64_t task1(std::vector<std::string> input)
+std::tuple<int, int> fiendReflections(const CharGrid& field)
 {
-  auto fields = splitOnEmptyRows(input);
+  return findReflections(field, 0);
+}
 
-  int64_t result{};
+std::tuple<int, int> fiendReflectionsWithSmudges(const CharGrid& field)
+{
+  return findReflections(field, 1);
+}
 
-  for (auto& field : fields) {
-    auto [x, y] = fiendReflections(field);
-    result += x + (100 * y);
-  }
+// A field is a few hundred bytes, chunks of them keep the per chunk overhead low. Fields are viewed in place if the
+// input lines point into buffer, otherwise they are copied.
+constexpr std::size_t fieldsPerChunk = 32;
 
-  return result;
+int64_t task1(Lines input, std::string_view buffer = {})
+{
+  auto fields = splitOnEmptyRows(input);
+  return parallelTransformReduce(
+      fields, int64_t{0}, std::plus<>{},
+      [buffer](Lines field) -> int64_t {
+        auto [x, y] = fiendReflections(charGrid(field, buffer));
+        return x + (100 * y);
+      },
+      fieldsPerChunk);
 }
 
-int64_t task2(std::vector<std::string> input)
+int64_t task2(Lines input, std::string_view buffer = {})
 {
   auto fields = splitOnEmptyRows(input);
+  return parallelTransformReduce(
+      fields, int64_t{0}, std::plus<>{},
+      [buffer](Lines field) -> int64_t {
+        auto [x, y] = fiendReflectionsWithSmudges(charGrid(field, buffer));
+        return x + (100 * y);
+      },
+      fieldsPerChunk);
+}
 
-  int64_t result{};
+// Single pass over the input with constant memory
+std::pair<int64_t, int64_t> solveStreaming(const std::filesystem::path& path,
+                                           std::size_t bufferSize = LineStream::defaultBufferSize)
+{
+  std::pair<int64_t, int64_t> result{};
+  forEachBlock(
+      path,
+      [&result](Lines lines) {
+        auto field = charGrid(lines);
+        auto [x1, y1] = fiendReflections(field);
+        result.first += x1 + (100 * y1);
+        auto [x2, y2] = fiendReflectionsWithSmudges(field);
+        result.second += x2 + (100 * y2);
+      },
+      bufferSize);
+  return result;
+}
 
-  for (auto& field : fields) {
-    auto [x, y] = fiendReflectionsWithSmudges(field);
-    result += x + (100 * y);
+// Entry point of the aoc runner
+Answers solve(const MappedInput& input, TaskSelection tasks)
+{
+  Answers answers;
+  if (tasks.task1) {
+    AOC_PROFILE_ZONE("task1");
+    answers.task1 = task1(input.lines(), input.data());
   }
-
-  return result;
+  if (tasks.task2) {
+    AOC_PROFILE_ZONE("task2");
+    answers.task2 = task2(input.lines(), input.data());
+  }
+  return answers;
 }
+}  // namespace day13
+
+#ifdef AOC_TESTS
+using namespace day13;
 
 TEST_CASE("Task1 and 2 example input")
 {
   // clang-format off
-  std::vector<std::string> input = {
+  std::vector<std::string_view> input = {
     "#.##..##.",
     "..#.##.#.",
     "##......#",
@@ -179,12 +167,82 @@ TEST_CASE("Task1 and 2 example input")
 
   REQUIRE(task1(input) == 405);
   REQUIRE(task2(input) == 400);
+
+  TempFile file("aoc_day13_stream_test");
+  {
+    std::ofstream out(file.path());
+    for (auto line : input) {
+      out << line << '\n';
+    }
+  }
+  // Buffer smaller than a line forces refills and buffer growth
+  REQUIRE(solveStreaming(file.path(), 4) == std::pair<int64_t, int64_t>{405, 400});
+}
+
+TEST_CASE("Transposed field")
+{
+  // Larger than one transpose block in both directions
+  std::vector<std::string> rows;
+  for (std::size_t y = 0; y < 70; y++) {
+    rows.emplace_back();
+    for (std::size_t x = 0; x < 45; x++) {
+      rows.back() += ((x * 7) + (y * 13)) % 5 == 0 ? '#' : '.';
+    }
+  }
+  std::vector<std::string_view> lines(rows.begin(), rows.end());
+
+  // Separate strings are always copied
+  auto field = charGrid(lines);
+  REQUIRE_FALSE(field.isView());
+  auto transposed = field.transposed(16);
+  REQUIRE(transposed.width() == 70);
+  REQUIRE(transposed.height() == 45);
+  for (std::size_t x = 0; x < field.width(); x++) {
+    REQUIRE(r::equal(transposed.row(x), field.column(x)));
+  }
+
+  // Lines of one buffer are viewed in place, unless they are not laid out at a constant stride
+  std::string buffer;
+  for (const auto& row : rows) {
+    buffer += row + '\n';
+  }
+  auto bufferLines = splitLines(buffer);
+  auto view = charGrid(bufferLines, buffer);
+  REQUIRE(view.isView());
+  REQUIRE(view.stride() == 46);
+  REQUIRE(r::equal(view.row(69), field.row(69)));
+  std::swap(bufferLines[0], bufferLines[1]);
+  REQUIRE_FALSE(charGrid(bufferLines, buffer).isView());
+}
+
+TEST_CASE("Generated input")
+{
+  // The generator only plants reflections it knows the answers of
+  std::pair<int64_t, int64_t> expected;
+  auto input =
+      generateToString([&expected](std::ostream& out) { expected = generateDay13(out, {.patterns = 500}, 42); });
+  auto lines = splitLines(input);
+
+  REQUIRE(task1(lines, input) == expected.first);
+  REQUIRE(task2(lines, input) == expected.second);
 }
 
 TEST_CASE("Tasks")
 {
-  auto input = readLines("../../day13/input.txt");
+  auto [task1, task2] = solveStreaming("../../day13/input.txt");
   //
-  fmt::println("Day13 Task1 result: {}", task1(input));
-  fmt::println("Day13 Task2 result: {}", task2(input));
+  fmt::println("Day13 Task1 result: {}", task1);
+  fmt::println("Day13 Task2 result: {}", task2);
+}
+
+TEST_CASE("Benchmark", "[.benchmark]")
+{
+  const std::filesystem::path path = benchmarkInputPath("day13");
+  MappedInput input(path);
+  Benchmark bench("day13", input);
+  bench.run("read", [&] { return MappedInput(path); });
+  bench.run("task1", [&] { return task1(input.lines(), input.data()); });
+  bench.run("task2", [&] { return task2(input.lines(), input.data()); });
+  bench.run("stream", [&] { return solveStreaming(path); });
 }
+#endif  // AOC_TESTS
@@ -1,19 +1,31 @@
 #include "common.hpp"
+#include "profile.hpp"
+#include "solvers.hpp"
 
 #include "scn/external/nanorange/nanorange.hpp"
 #include <algorithm>
 #include <array>
-#include <catch2/catch_test_macros.hpp>
 #include <cstdint>
+#include <filesystem>
 #include <fmt/core.h>
 #include <fmt/format.h>
 #include <numeric>
 #include <scn/scan.h>
 #include <sstream>
+#include <stdexcept>
 #include <string>
 #include <utility>
 #include <vector>
 
+#ifdef AOC_TESTS
+#include "bench.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+#endif
+
+namespace day15
+{
+
 // int64_t task1(std::vector<std::string> input)
 // {
 // }
@@ -95,6 +107,28 @@ int64_t task2(std::string input)
   return focalStr;
 }
 
+// Entry point of the aoc runner
+Answers solve(const MappedInput& input, TaskSelection tasks)
+{
+  if (input.empty()) {
+    throw std::runtime_error("Invalid input, expected one line of steps");
+  }
+  Answers answers;
+  if (tasks.task1) {
+    AOC_PROFILE_ZONE("task1");
+    answers.task1 = task1(input[0]);
+  }
+  if (tasks.task2) {
+    AOC_PROFILE_ZONE("task2");
+    answers.task2 = task2(std::string(input[0]));
+  }
+  return answers;
+}
+}  // namespace day15
+
+#ifdef AOC_TESTS
+using namespace day15;
+
 TEST_CASE("Task1 and 2 example input")
 {
   // clang-format off
@@ -107,8 +141,19 @@ TEST_CASE("Task1 and 2 example input")
 
 TEST_CASE("Tasks")
 {
-  auto input = readLines("../../day15/input.txt");
+  MappedInput input("../../day15/input.txt");
   //
   fmt::println("Day15 Task1 result: {}", task1(input[0]));
-  fmt::println("Day15 Task2 result: {}", task2(input[0]));
+  fmt::println("Day15 Task2 result: {}", task2(std::string(input[0])));
+}
+
+TEST_CASE("Benchmark", "[.benchmark]")
+{
+  const std::filesystem::path path = benchmarkInputPath("day15");
+  MappedInput input(path);
+  Benchmark bench("day15", input);
+  bench.run("read", [&] { return MappedInput(path); });
+  bench.run("task1", [&] { return task1(input[0]); });
+  bench.run("task2", [&] { return task2(std::string(input[0])); });
 }
+#endif  // AOC_TESTS
@@ -1,15 +1,43 @@
 #include "common.hpp"
-
-#include <catch2/catch_test_macros.hpp>
+#include "profile.hpp"
+#include "small_vector.hpp"
+#include "solvers.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <filesystem>
 #include <fmt/format.h>
+#include <functional>
 #include <iostream>
+#include <limits>
 #include <numeric>
+#include <optional>
 #include <scn/scan.h>
+#include <span>
+#include <stdexcept>
 #include <string_view>
+#include <utility>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#ifdef AOC_TESTS
+#include "bench.hpp"
+#include "generators.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+#endif
 
 namespace r = std::ranges;
 namespace v = std::ranges::views;
 
+namespace day2
+{
+
 struct Game
 {
   int id{-1};
@@ -22,7 +50,8 @@ struct Game
     bool operator==(const Drawing&) const = default;
   };
 
-  std::vector<Drawing> drawings;
+  // Real inputs have at most six drawings per game, they are stored inline
+  SmallVector<Drawing, 6> drawings;
 
   bool operator==(const Game&) const = default;
   static Game fromStr(std::string_view v);
@@ -30,6 +59,8 @@ struct Game
 
 using Bag = Game::Drawing;
 
+constexpr Bag task1Bag = {.red = 12, .green = 13, .blue = 14};
+
 bool possible(const Game& game, Bag bag)
 {
   for (const auto& drawing : game.drawings) {
@@ -54,19 +85,354 @@ Bag getMinimumBag(const Game& game)
 
 int64_t task1(const std::vector<Game>& games)
 {
-  Bag bag = {.red = 12, .green = 13, .blue = 14};
-  return std::accumulate(games.begin(), games.end(), static_cast<int64_t>(0),
-                         [bag](int64_t sum, const Game& game) { return sum + (possible(game, bag) ? game.id : 0); });
+  return parallelTransformReduce(games, int64_t{0}, std::plus<>{}, [](const Game& game) -> int64_t {
+    return possible(game, task1Bag) ? game.id : 0;
+  });
 }
 
 int64_t task2(const std::vector<Game>& games)
 {
-  return std::accumulate(games.begin(), games.end(), static_cast<int64_t>(0), [](int64_t sum, const Game& game) {
+  return parallelTransformReduce(games, int64_t{0}, std::plus<>{}, [](const Game& game) -> int64_t {
     auto minBag = getMinimumBag(game);
-    return sum + (minBag.red * minBag.green * minBag.blue);
+    return minBag.red * minBag.green * minBag.blue;
   });
 }
 
+// A game reduced to what both tasks need
+struct GameSummary
+{
+  int id{-1};
+  Bag minimumBag{};
+
+  bool operator==(const GameSummary&) const = default;
+};
+
+// Fused counterpart of fromStr + getMinimumBag: one pass over the line, every drawing is folded into the running
+// maximum as soon as it ends. Like in fromStr, counts of colors other than red, green and blue are ignored.
+GameSummary summarizeGame(std::string_view line)
+{
+  const char* p = line.data();
+  const char* end = p + line.size();
+  auto parseNumber = [&p, end] {
+    if (p == end || *p < '0' || *p > '9') {
+      throw std::runtime_error("Parse error!");
+    }
+    int value = 0;
+    for (; p != end && *p >= '0' && *p <= '9'; p++) {
+      value = (value * 10) + (*p - '0');
+    }
+    return value;
+  };
+
+  constexpr std::string_view prefix = "Game ";
+  if (!line.starts_with(prefix)) {
+    throw std::runtime_error("Parse error!");
+  }
+  p += prefix.size();
+  GameSummary summary;
+  summary.id = parseNumber();
+  if (p == end || *p++ != ':') {
+    throw std::runtime_error("Parse error!");
+  }
+
+  Bag drawing{};
+  auto& bag = summary.minimumBag;
+  auto foldDrawing = [&bag, &drawing] {
+    bag.red = std::max(bag.red, drawing.red);
+    bag.green = std::max(bag.green, drawing.green);
+    bag.blue = std::max(bag.blue, drawing.blue);
+    drawing = {};
+  };
+  while (p != end) {
+    while (p != end && *p == ' ') {
+      p++;
+    }
+    if (p == end) {
+      break;
+    }
+    int count = parseNumber();
+    while (p != end && *p == ' ') {
+      p++;
+    }
+    const char* colorBegin = p;
+    while (p != end && *p != ',' && *p != ';' && *p != ' ') {
+      p++;
+    }
+    std::string_view color(colorBegin, static_cast<std::size_t>(p - colorBegin));
+    while (p != end && *p != ',' && *p != ';') {
+      p++;
+    }
+    if (color == "red") {
+      drawing.red += count;
+    } else if (color == "green") {
+      drawing.green += count;
+    } else if (color == "blue") {
+      drawing.blue += count;
+    }
+
+    if (p != end && *p++ == ';') {
+      foldDrawing();
+    }
+  }
+  // The last drawing ends with the line, also if a separator comes before
+  foldDrawing();
+  return summary;
+}
+
+using Totals = std::pair<int64_t, int64_t>;
+
+Totals addTotals(Totals a, Totals b)
+{
+  return {a.first + b.first, a.second + b.second};
+}
+
+// Task1 and task2 contributions of one game
+Totals gameTotals(const GameSummary& game, Bag bag = task1Bag)
+{
+  const auto& minBag = game.minimumBag;
+  bool isPossible = minBag.red <= bag.red && minBag.green <= bag.green && minBag.blue <= bag.blue;
+  return {isPossible ? game.id : 0, static_cast<int64_t>(minBag.red) * minBag.green * minBag.blue};
+}
+
+// Both tasks over a buffer of whole lines, no Game or drawing list is ever built
+Totals sumGames(std::string_view text)
+{
+  Totals totals{};
+  while (!text.empty()) {
+    auto newline = text.find('\n');
+    auto line = text.substr(0, newline);
+    if (!line.empty()) {
+      totals = addTotals(totals, gameTotals(summarizeGame(line)));
+    }
+    text.remove_prefix(newline == std::string_view::npos ? text.size() : newline + 1);
+  }
+  return totals;
+}
+
+// Bytes per piece of the parallel fused pass
+constexpr std::size_t pieceSize = 256 * 1024;
+
+// Single pass over the input with constant memory
+Totals solveStreaming(const std::filesystem::path& path)
+{
+  Totals result{};
+  forEachLine(path, [&result](std::string_view line) { result = addTotals(result, gameTotals(summarizeGame(line))); });
+  return result;
+}
+
+// Answers "which games are possible with this bag" for many bags against one game set. Every game is reduced to its
+// minimum bag once and stored column wise, a query then compares eight games per instruction (AVX2, scalar
+// otherwise). An optional dominance index turns id sum queries into three binary searches and one table lookup.
+class BagQueryEngine
+{
+public:
+  explicit BagQueryEngine(std::span<const GameSummary> games) : size_(games.size())
+  {
+    // Padding games never fit, so the SIMD loops need no tail handling
+    auto padded = (games.size() + blockSize - 1) / blockSize * blockSize;
+    red_.assign(padded, std::numeric_limits<int32_t>::max());
+    green_.assign(padded, std::numeric_limits<int32_t>::max());
+    blue_.assign(padded, std::numeric_limits<int32_t>::max());
+    ids_.assign(padded, 0);
+    for (std::size_t i = 0; i < games.size(); i++) {
+      red_[i] = games[i].minimumBag.red;
+      green_[i] = games[i].minimumBag.green;
+      blue_[i] = games[i].minimumBag.blue;
+      ids_[i] = games[i].id;
+    }
+  }
+
+  static BagQueryEngine fromText(std::string_view text)
+  {
+    return BagQueryEngine(parallelTransform(splitLines(text), summarizeGame));
+  }
+
+  std::size_t size() const
+  {
+    return size_;
+  }
+
+  // Sum of the ids of all games possible with bag
+  int64_t idSum(Bag bag) const
+  {
+    if (index_) {
+      return index_->idSum(bag);
+    }
+    int64_t sum{};
+#if defined(__AVX2__)
+    const __m256i red = _mm256_set1_epi32(bag.red);
+    const __m256i green = _mm256_set1_epi32(bag.green);
+    const __m256i blue = _mm256_set1_epi32(bag.blue);
+    __m256i low = _mm256_setzero_si256();
+    __m256i high = _mm256_setzero_si256();
+    for (std::size_t i = 0; i < ids_.size(); i += blockSize) {
+      __m256i tooMany = _mm256_or_si256(
+          _mm256_or_si256(_mm256_cmpgt_epi32(load(red_, i), red), _mm256_cmpgt_epi32(load(green_, i), green)),
+          _mm256_cmpgt_epi32(load(blue_, i), blue));
+      __m256i ids = _mm256_andnot_si256(tooMany, load(ids_, i));
+      // Widened to 64 bit lanes, a large game set overflows 32 bit sums
+      low = _mm256_add_epi64(low, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(ids)));
+      high = _mm256_add_epi64(high, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(ids, 1)));
+    }
+    alignas(32) std::array<int64_t, 4> lanes{};
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes.data()), _mm256_add_epi64(low, high));
+    sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#else
+    for (std::size_t i = 0; i < size_; i++) {
+      if (red_[i] <= bag.red && green_[i] <= bag.green && blue_[i] <= bag.blue) {
+        sum += ids_[i];
+      }
+    }
+#endif
+    return sum;
+  }
+
+  // Bit i (of word i / 64) is set if game i is possible with bag
+  std::vector<uint64_t> possibleGames(Bag bag) const
+  {
+    std::vector<uint64_t> bitmap((size_ + 63) / 64);
+    for (std::size_t i = 0; i < ids_.size(); i += blockSize) {
+      bitmap[i / 64] |= static_cast<uint64_t>(possibleBlock(bag, i)) << (i % 64);
+    }
+    if (size_ % 64 != 0) {
+      bitmap.back() &= (uint64_t{1} << (size_ % 64)) - 1;
+    }
+    return bitmap;
+  }
+
+  // Batches run in parallel, one bag per task
+  std::vector<int64_t> idSums(std::span<const Bag> bags) const
+  {
+    return parallelTransform(bags, [this](Bag bag) { return idSum(bag); }, 1);
+  }
+
+  std::vector<std::vector<uint64_t>> possibleGames(std::span<const Bag> bags) const
+  {
+    return parallelTransform(bags, [this](Bag bag) { return possibleGames(bag); }, 1);
+  }
+
+  // Prefix sums of the ids over the distinct red, green and blue values. Pays off for large query batches, the
+  // table has one entry per combination of distinct values and building it is refused beyond maxCells.
+  bool buildDominanceIndex(std::size_t maxCells = std::size_t{1} << 24)
+  {
+    DominanceIndex index;
+    auto distinct = [this](const std::vector<int32_t>& column) {
+      std::vector<int32_t> values(column.begin(), column.begin() + static_cast<std::ptrdiff_t>(size_));
+      r::sort(values);
+      values.erase(std::unique(values.begin(), values.end()), values.end());
+      return values;
+    };
+    index.red = distinct(red_);
+    index.green = distinct(green_);
+    index.blue = distinct(blue_);
+    // One extra slot per axis for "below every value"
+    index.strideBlue = index.blue.size() + 1;
+    index.strideGreen = (index.green.size() + 1) * index.strideBlue;
+    auto cells = (index.red.size() + 1) * index.strideGreen;
+    if (cells > maxCells) {
+      return false;
+    }
+
+    index.sums.assign(cells, 0);
+    auto slot = [](const std::vector<int32_t>& values, int32_t value) {
+      return static_cast<std::size_t>(r::lower_bound(values, value) - values.begin()) + 1;
+    };
+    for (std::size_t i = 0; i < size_; i++) {
+      index.sums[index.cell(slot(index.red, red_[i]), slot(index.green, green_[i]), slot(index.blue, blue_[i]))] +=
+          ids_[i];
+    }
+    // Inclusive prefix sums along each axis in turn
+    for (std::size_t x = 1; x <= index.red.size(); x++) {
+      for (std::size_t y = 1; y <= index.green.size(); y++) {
+        for (std::size_t z = 1; z <= index.blue.size(); z++) {
+          index.sums[index.cell(x, y, z)] += index.sums[index.cell(x, y, z - 1)];
+        }
+      }
+    }
+    for (std::size_t x = 1; x <= index.red.size(); x++) {
+      for (std::size_t y = 1; y <= index.green.size(); y++) {
+        for (std::size_t z = 1; z <= index.blue.size(); z++) {
+          index.sums[index.cell(x, y, z)] += index.sums[index.cell(x, y - 1, z)];
+        }
+      }
+    }
+    for (std::size_t x = 1; x <= index.red.size(); x++) {
+      for (std::size_t y = 1; y <= index.green.size(); y++) {
+        for (std::size_t z = 1; z <= index.blue.size(); z++) {
+          index.sums[index.cell(x, y, z)] += index.sums[index.cell(x - 1, y, z)];
+        }
+      }
+    }
+    index_ = std::move(index);
+    return true;
+  }
+
+  bool hasDominanceIndex() const
+  {
+    return index_.has_value();
+  }
+
+private:
+  static constexpr std::size_t blockSize = 8;
+
+  struct DominanceIndex
+  {
+    std::vector<int32_t> red;
+    std::vector<int32_t> green;
+    std::vector<int32_t> blue;
+    std::size_t strideGreen{};
+    std::size_t strideBlue{};
+    std::vector<int64_t> sums;
+
+    std::size_t cell(std::size_t x, std::size_t y, std::size_t z) const
+    {
+      return (x * strideGreen) + (y * strideBlue) + z;
+    }
+
+    int64_t idSum(Bag bag) const
+    {
+      // Number of distinct values <= the bag's, which is the slot holding all games up to it
+      auto slot = [](const std::vector<int32_t>& values, int32_t value) {
+        return static_cast<std::size_t>(r::upper_bound(values, value) - values.begin());
+      };
+      return sums[cell(slot(red, bag.red), slot(green, bag.green), slot(blue, bag.blue))];
+    }
+  };
+
+#if defined(__AVX2__)
+  static __m256i load(const std::vector<int32_t>& column, std::size_t i)
+  {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(column.data() + i));
+  }
+#endif
+
+  // Bit j is set if game base + j is possible
+  uint32_t possibleBlock(Bag bag, std::size_t base) const
+  {
+#if defined(__AVX2__)
+    __m256i tooManyRed = _mm256_cmpgt_epi32(load(red_, base), _mm256_set1_epi32(bag.red));
+    __m256i tooManyGreen = _mm256_cmpgt_epi32(load(green_, base), _mm256_set1_epi32(bag.green));
+    __m256i tooManyBlue = _mm256_cmpgt_epi32(load(blue_, base), _mm256_set1_epi32(bag.blue));
+    __m256i tooMany = _mm256_or_si256(_mm256_or_si256(tooManyRed, tooManyGreen), tooManyBlue);
+    return ~static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(tooMany))) & 0xFF;
+#else
+    uint32_t bits = 0;
+    for (std::size_t j = 0; j < blockSize; j++) {
+      auto i = base + j;
+      bits |= static_cast<uint32_t>(red_[i] <= bag.red && green_[i] <= bag.green && blue_[i] <= bag.blue) << j;
+    }
+    return bits;
+#endif
+  }
+
+  std::size_t size_;
+  std::vector<int32_t> red_;
+  std::vector<int32_t> green_;
+  std::vector<int32_t> blue_;
+  std::vector<int32_t> ids_;
+  std::optional<DominanceIndex> index_;
+};
+
 std::ostream& operator<<(std::ostream& os, Game const& value)
 {
   os << "id: " << value.id << ", Drawings: ";
@@ -136,6 +502,27 @@ Game Game::fromStr(std::string_view v)
   return game;
 }
 
+// Entry point of the aoc runner
+Answers solve(const MappedInput& input, TaskSelection tasks)
+{
+  // Parsing and both tasks are one fused pass, there is no separate parse or task zone
+  AOC_PROFILE_ZONE("fused");
+  auto [total1, total2] =
+      parallelTransformReduce(splitIntoLineChunks(input.data(), pieceSize), Totals{}, addTotals, sumGames, 1);
+  Answers answers;
+  if (tasks.task1) {
+    answers.task1 = total1;
+  }
+  if (tasks.task2) {
+    answers.task2 = total2;
+  }
+  return answers;
+}
+}  // namespace day2
+
+#ifdef AOC_TESTS
+using namespace day2;
+
 TEST_CASE("Inputs Task1")
 {
   std::vector games = {Game::fromStr("Game 1: 3 blue, 4 red; 1 red, 2 green, 6 blue; 2 green"),
@@ -150,7 +537,6 @@ TEST_CASE("Inputs Task1")
   REQUIRE(games[3] == Game{.id = 4, .drawings = {{3, 1, 6}, {6, 3, 0}, {14, 3, 15}}});
   REQUIRE(games[4] == Game{.id = 5, .drawings = {{6, 3, 1}, {1, 2, 2}}});
 
-  Bag task1Bag = {.red = 12, .green = 13, .blue = 14};
   REQUIRE(possible(games[0], task1Bag));
   REQUIRE(possible(games[1], task1Bag));
   REQUIRE(!possible(games[2], task1Bag));
@@ -177,24 +563,117 @@ TEST_CASE("Inputs Task2")
   REQUIRE(task2(games) == 2286);
 }
 
-TEST_CASE("Task1")
+TEST_CASE("Fused parser")
 {
-  auto input = readLines("../../day2/input.txt");
-  std::vector<Game> games;
-  games.reserve(input.size());
-  for (const auto& l : input) {
-    games.emplace_back(Game::fromStr(l));
+  std::string_view input = "Game 1: 3 blue, 4 red; 1 red, 2 green, 6 blue; 2 green\n"
+                           "Game 2: 1 blue, 2 green; 3 green, 4 blue, 1 red; 1 green, 1 blue\n"
+                           "Game 3: 8 green, 6 blue, 20 red; 5 blue, 4 red, 13 green; 5 green, 1 red\n"
+                           "Game 4: 1 green, 3 red, 6 blue; 3 green, 6 red; 3 green, 15 blue, 14 red\n"
+                           "Game 5: 6 red, 1 blue, 3 green; 2 blue, 1 red, 2 green\n";
+
+  REQUIRE(summarizeGame("Game 3: 8 green, 6 blue, 20 red; 5 blue, 4 red, 13 green; 5 green, 1 red") ==
+          GameSummary{.id = 3, .minimumBag = {20, 13, 6}});
+  REQUIRE(summarizeGame("Game 12: 2 red, 3 red") == GameSummary{.id = 12, .minimumBag = {5, 0, 0}});
+  REQUIRE(sumGames(input) == Totals{8, 2286});
+  REQUIRE(sumGames(input.substr(0, input.size() - 1)) == Totals{8, 2286});
+  REQUIRE_THROWS_AS(summarizeGame("Game x: 1 red"), std::runtime_error);
+  REQUIRE_THROWS_AS(summarizeGame("Game 1: red"), std::runtime_error);
+
+  // Whole color words, unknown colors are ignored and a trailing separator still ends the last drawing
+  for (std::string_view line :
+       {"Game 6: 4 rose, 2 red; 7 black, 1 blue, 3 greenish", "Game 7: 2 red, 3 blue,", "Game 8: 1 green; 5 red;"}) {
+    auto game = Game::fromStr(line);
+    REQUIRE(summarizeGame(line) == GameSummary{.id = game.id, .minimumBag = getMinimumBag(game)});
+  }
+  REQUIRE(summarizeGame("Game 7: 2 red, 3 blue,") == GameSummary{.id = 7, .minimumBag = {2, 0, 3}});
+
+  // Agrees with fromStr + getMinimumBag on generated games
+  auto text = generateToString([](std::ostream& out) { generateDay2(out, {.games = 500}, 9); });
+  for (auto line : splitLines(text)) {
+    auto game = Game::fromStr(line);
+    REQUIRE(summarizeGame(line) == GameSummary{.id = game.id, .minimumBag = getMinimumBag(game)});
   }
-  std::cout << std::format("Day2 Task1 result: {}\n", task1(games));
 }
 
-TEST_CASE("Task2")
+TEST_CASE("Bag query engine")
 {
-  auto input = readLines("../../day2/input.txt");
-  std::vector<Game> games;
-  games.reserve(input.size());
-  for (const auto& l : input) {
-    games.emplace_back(Game::fromStr(l));
+  auto text = generateToString([](std::ostream& out) { generateDay2(out, {.games = 1000}, 11); });
+  auto games = parallelTransform(splitLines(text), summarizeGame);
+  BagQueryEngine engine(games);
+  REQUIRE(engine.size() == 1000);
+
+  std::vector<Bag> bags = {task1Bag, {}, {.red = 1000, .green = 1000, .blue = 1000}};
+  SeededRng rng(5);
+  for (int i = 0; i < 200; i++) {
+    bags.push_back({.red = static_cast<int>(rng.uniform(0, 60)),
+                    .green = static_cast<int>(rng.uniform(0, 60)),
+                    .blue = static_cast<int>(rng.uniform(0, 60))});
+  }
+
+  std::vector<int64_t> expected;
+  for (const auto& bag : bags) {
+    int64_t sum{};
+    for (const auto& game : games) {
+      sum += gameTotals(game, bag).first;
+    }
+    expected.push_back(sum);
+  }
+  REQUIRE(engine.idSums(bags) == expected);
+
+  auto bitmaps = engine.possibleGames(bags);
+  for (std::size_t b = 0; b < bags.size(); b++) {
+    int64_t sum{};
+    std::size_t setBits{};
+    for (std::size_t i = 0; i < games.size(); i++) {
+      if ((bitmaps[b][i / 64] >> (i % 64)) & 1) {
+        sum += games[i].id;
+      }
+    }
+    for (auto word : bitmaps[b]) {
+      setBits += static_cast<std::size_t>(std::popcount(word));
+    }
+    REQUIRE(sum == expected[b]);
+    REQUIRE(setBits <= games.size());
+  }
+
+  REQUIRE(!engine.buildDominanceIndex(10));
+  REQUIRE(engine.buildDominanceIndex());
+  REQUIRE(engine.hasDominanceIndex());
+  REQUIRE(engine.idSums(bags) == expected);
+}
+
+TEST_CASE("Tasks")
+{
+  auto [task1, task2] = solveStreaming("../../day2/input.txt");
+  std::cout << std::format("Day2 Task1 result: {}\n", task1);
+  std::cout << std::format("Day2 Task2 result: {}\n", task2);
+}
+
+TEST_CASE("Benchmark", "[.benchmark]")
+{
+  const std::filesystem::path path = benchmarkInputPath("day2");
+  MappedInput input(path);
+  Benchmark bench("day2", input);
+  bench.run("read", [&] { return MappedInput(path); });
+  auto games = bench.run("parse", [&] {
+    std::vector<Game> games;
+    games.reserve(input.size());
+    for (auto line : input) {
+      games.emplace_back(Game::fromStr(line));
+    }
+    return games;
+  });
+  bench.run("task1", [&] { return task1(games); });
+  bench.run("task2", [&] { return task2(games); });
+  bench.run("fused", [&] { return sumGames(input.data()); });
+  auto engine = bench.run("query engine", [&] { return BagQueryEngine::fromText(input.data()); });
+  std::vector<Bag> bags;
+  for (int i = 0; i < 4096; i++) {
+    bags.push_back({.red = i % 16, .green = 4 + (i / 16 % 16), .blue = 8 + (i / 256)});
   }
-  std::cout << std::format("Day2 Task2 result: {}\n", task2(games));
+  bench.run("4096 bags", [&] { return engine.idSums(bags); });
+  engine.buildDominanceIndex();
+  bench.run("4096 bags indexed", [&] { return engine.idSums(bags); });
+  bench.run("stream", [&] { return solveStreaming(path); });
 }
+#endif  // AOC_TESTS
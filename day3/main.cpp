@@ -1,60 +1,98 @@
 #include "common.hpp"
+#include "grid2d.hpp"
+#include "integer_scanner.hpp"
+#include "profile.hpp"
+#include "small_vector.hpp"
+#include "solvers.hpp"
 
-#include <catch2/catch_test_macros.hpp>
+#include <algorithm>
+#include <array>
+#include <bit>
 #include <cctype>
+#include <cstdint>
+#include <filesystem>
 #include <fmt/format.h>
+#include <fstream>
 #include <iostream>
 #include <map>
+#include <memory_resource>
 #include <numeric>
+#include <optional>
+#include <ranges>
 #include <scn/scan.h>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#ifdef AOC_TESTS
+#include "bench.hpp"
+#include "generators.hpp"
+#include "temp_file.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+#endif
 
 namespace r = std::ranges;
 namespace v = std::ranges::views;
 
+namespace day3
+{
+
 bool isSymbol(char c)
 {
   return !std::isdigit(c) && c != '.';
 }
 
-bool isLocSymbol(const std::vector<std::string>& grid, std::size_t x, std::size_t y)
+using Schematic = Grid2D<char>;
+
+// Surrounded by a border of '.', so every neighbor of a cell can be looked at without bounds checks
+Schematic parseSchematic(Lines lines)
 {
-  if (y < grid.size() && x < grid[y].size()) {
-    return isSymbol(grid[y][x]);
-  }
-  return false;
+  return Schematic::fromLines(lines, 1, '.');
 }
 
-bool isGear(const std::vector<std::string>& grid, std::size_t x, std::size_t y)
+bool isLocSymbol(const Schematic& grid, std::ptrdiff_t x, std::ptrdiff_t y)
 {
-  if (y < grid.size() && x < grid[y].size()) {
-    return grid[y][x] == '*';
-  }
-  return false;
+  return isSymbol(grid(x, y));
+}
+
+bool isGear(const Schematic& grid, std::ptrdiff_t x, std::ptrdiff_t y)
+{
+  return grid(x, y) == '*';
 }
 
-std::vector<int64_t> getPartNumbers(const std::vector<std::string>& grid, int64_t& sumGearRatios)
+std::vector<int64_t> getPartNumbers(const Schematic& grid, int64_t& sumGearRatios)
 {
+  AOC_PROFILE_FUNCTION();
   std::vector<int64_t> partNumbers;
   std::vector<int64_t> gearRatios;
-  std::map<std::tuple<int, int>, std::vector<int>> gearPartNumbers;
-  for (std::size_t y = 0; y < grid.size(); y++) {
-    auto line = grid[y];
+  // All map nodes and part number lists come from the arena and are released together
+  std::pmr::monotonic_buffer_resource arena;
+  std::pmr::map<std::tuple<int, int>, std::pmr::vector<int64_t>> gearPartNumbers(&arena);
+  const auto width = static_cast<std::ptrdiff_t>(grid.width());
+  for (std::ptrdiff_t y = 0; y < static_cast<std::ptrdiff_t>(grid.height()); y++) {
     bool inDigit = false;
     bool isPartNumber = false;
-    std::string number;
-    std::vector<std::pair<int, int>> gearNeighbors;
+    int64_t number{};
+    // A number touches at most a handful of gears
+    SmallVector<std::pair<int, int>, 8> gearNeighbors;
 
-    auto markGears = [&](std::size_t x, std::size_t y) {
+    auto markGears = [&](std::ptrdiff_t x, std::ptrdiff_t y) {
       if (isGear(grid, x, y)) {
-        gearNeighbors.emplace_back(x, y);
+        gearNeighbors.emplace_back(static_cast<int>(x), static_cast<int>(y));
       }
     };
 
-    for (std::size_t x = 0; x < line.size(); x++) {
-      if (std::isdigit(line[x])) {
+    // Runs onto the right border, so a number at the end of a row is closed like any other
+    for (std::ptrdiff_t x = 0; x <= width; x++) {
+      if (std::isdigit(grid(x, y))) {
         // For the first check left and diagnoals as well
         if (!inDigit) {
-          number.clear();
+          number = 0;
           gearNeighbors.clear();
           inDigit = true;
           isPartNumber = false;
@@ -72,7 +110,7 @@ std::vector<int64_t> getPartNumbers(const std::vector<std::string>& grid, int64_
         }
         markGears(x, y - 1);
         markGears(x, y + 1);
-        number.append(1, line[x]);
+        number = (number * 10) + (grid(x, y) - '0');
       } else if (inDigit) {
         // End so we have to check diagonals
         inDigit = false;
@@ -84,23 +122,7 @@ std::vector<int64_t> getPartNumbers(const std::vector<std::string>& grid, int64_
         markGears(x, y + 1);
 
         if (isPartNumber) {
-          partNumbers.push_back(std::stoi(number));
-          for (auto& gPos : gearNeighbors) {
-            gearPartNumbers[gPos].emplace_back(partNumbers.back());
-          }
-        }
-      }
-      if (x == (line.size() - 1) && inDigit) {
-        inDigit = false;
-        if (isLocSymbol(grid, x + 1, y) || isLocSymbol(grid, x + 1, y - 1) || isLocSymbol(grid, x + 1, y + 1)) {
-          isPartNumber = true;
-        }
-        markGears(x + 1, y);
-        markGears(x + 1, y - 1);
-        markGears(x + 1, y + 1);
-
-        if (isPartNumber) {
-          partNumbers.push_back(std::stoi(number));
+          partNumbers.push_back(number);
           for (auto& gPos : gearNeighbors) {
             gearPartNumbers[gPos].emplace_back(partNumbers.back());
           }
@@ -118,42 +140,401 @@ std::vector<int64_t> getPartNumbers(const std::vector<std::string>& grid, int64_
   return partNumbers;
 }
 
-int64_t task1(const std::vector<std::string>& grid)
+int64_t task1(const Schematic& grid)
 {
   [[maybe_unused]] int64_t sumGearRatios{};
   auto partNumbers = getPartNumbers(grid, sumGearRatios);
   return std::reduce(partNumbers.begin(), partNumbers.end());
 }
 
-int64_t task2(const std::vector<std::string>& grid)
+int64_t task2(const Schematic& grid)
 {
   int64_t sumGearRatios{};
   auto partNumbers = getPartNumbers(grid, sumGearRatios);
   return sumGearRatios;
 }
 
+// Bit-parallel engine, both tasks in one pass. Every row becomes digit, symbol and gear bitmasks (bit x of word
+// x / 64 stands for column x). Symbols are dilated by one cell with shifts and ORs over the row above, the row itself
+// and the row below, a digit run is a part number if it meets that mask. Gear ratios are collected per gear cell.
+struct SchematicSums
+{
+  int64_t partNumbers{};
+  int64_t gearRatios{};
+
+  bool operator==(const SchematicSums&) const = default;
+};
+
+std::size_t wordsForWidth(std::size_t width)
+{
+  return (width + 63) / 64;
+}
+
+struct RowMasks
+{
+  std::span<uint64_t> digits;
+  std::span<uint64_t> symbols;
+  std::span<uint64_t> gears;
+};
+
+void classifyRow(std::string_view row, const RowMasks& masks)
+{
+  r::fill(masks.digits, 0);
+  r::fill(masks.symbols, 0);
+  r::fill(masks.gears, 0);
+  for (std::size_t base = 0; base < row.size(); base += 64) {
+    auto count = std::min<std::size_t>(64, row.size() - base);
+    const char* chunk = row.data() + base;
+    uint64_t valid = count == 64 ? ~uint64_t{0} : (uint64_t{1} << count) - 1;
+    uint64_t digits = scanner_detail::digitMask(chunk, count);
+    masks.digits[base / 64] = digits;
+    masks.symbols[base / 64] = valid & ~digits & ~scanner_detail::byteMask(chunk, count, '.');
+    masks.gears[base / 64] = scanner_detail::byteMask(chunk, count, '*');
+  }
+}
+
+// out |= bits dilated by one column to the left and right
+void orDilated(std::span<const uint64_t> bits, std::span<uint64_t> out)
+{
+  for (std::size_t w = 0; w < bits.size(); w++) {
+    uint64_t fromLeft = (bits[w] << 1) | (w > 0 ? bits[w - 1] >> 63 : 0);
+    uint64_t fromRight = (bits[w] >> 1) | (w + 1 < bits.size() ? bits[w + 1] << 63 : 0);
+    out[w] |= bits[w] | fromLeft | fromRight;
+  }
+}
+
+// Calls fn(x) for every set bit x in [begin, end)
+template<class Fn>
+void forEachBitInRange(std::span<const uint64_t> bits, std::size_t begin, std::size_t end, Fn&& fn)
+{
+  for (std::size_t w = begin / 64; w * 64 < end; w++) {
+    uint64_t word = bits[w];
+    if (w == begin / 64) {
+      word &= ~uint64_t{0} << (begin % 64);
+    }
+    if ((w + 1) * 64 > end) {
+      word &= (uint64_t{1} << (end % 64)) - 1;
+    }
+    for (; word != 0; word &= word - 1) {
+      fn((w * 64) + static_cast<std::size_t>(std::countr_zero(word)));
+    }
+  }
+}
+
+bool anyBitInRange(std::span<const uint64_t> bits, std::size_t begin, std::size_t end)
+{
+  bool found = false;
+  forEachBitInRange(bits, begin, end, [&found](std::size_t) { found = true; });
+  return found;
+}
+
+// Calls fn(begin, end) for the digit runs of a row in order
+template<class Fn>
+void forEachDigitRun(std::span<const uint64_t> digits, Fn&& fn)
+{
+  uint64_t carry = 0;
+  std::size_t runStart = 0;
+  for (std::size_t w = 0; w < digits.size(); w++) {
+    uint64_t previous = (digits[w] << 1) | carry;
+    // Starts and ends alternate, the lowest pending event is always the next one
+    for (uint64_t events = (digits[w] & ~previous) | (~digits[w] & previous); events != 0; events &= events - 1) {
+      auto x = (w * 64) + static_cast<std::size_t>(std::countr_zero(events));
+      if ((digits[w] >> (x % 64)) & 1) {
+        runStart = x;
+      } else {
+        fn(runStart, x);
+      }
+    }
+    carry = digits[w] >> 63;
+  }
+  if (carry != 0) {
+    fn(runStart, digits.size() * 64);
+  }
+}
+
+// Feeds the engine one row at a time. A row is decided once the row below it arrived and a gear once the row below
+// it is decided, so only three rows of masks, characters and gear accumulators (flat arrays indexed by column) are
+// kept in a ring, whatever the height of the schematic.
+//
+// Rows pushed with owned = false are halo rows of a band: their numbers are not summed, but they still feed the
+// gears of the owned rows next to them. Gears in halo rows are left to the band owning them.
+class SchematicScanner
+{
+public:
+  explicit SchematicScanner(std::size_t width) : width_(width), words_(wordsForWidth(width))
+  {
+    for (auto& slot : ring_) {
+      slot.digits.resize(words_);
+      slot.symbols.resize(words_);
+      slot.gears.resize(words_);
+      slot.gearCounts.resize(width_);
+      slot.gearProducts.resize(width_);
+    }
+  }
+
+  void push(std::string_view row, bool owned = true)
+  {
+    if (row.size() > width_) {
+      throw std::runtime_error("Schematic row wider than the first one");
+    }
+    if (rows_ >= 3) {
+      finishGears(rows_ - 3);
+    }
+    auto& slot = ring_[rows_ % 3];
+    slot.chars.assign(row);
+    slot.owned = owned;
+    classifyRow(row, {.digits = slot.digits, .symbols = slot.symbols, .gears = slot.gears});
+    r::fill(slot.gearCounts, 0);
+    r::fill(slot.gearProducts, 1);
+    rows_++;
+    if (rows_ >= 2) {
+      scanRow(rows_ - 2);
+    }
+  }
+
+  SchematicSums finish()
+  {
+    if (rows_ >= 1) {
+      scanRow(rows_ - 1);
+    }
+    for (auto y = rows_ >= 3 ? rows_ - 3 : 0; y < rows_; y++) {
+      finishGears(y);
+    }
+    rows_ = 0;
+    return std::exchange(sums_, {});
+  }
+
+private:
+  struct Row
+  {
+    std::string chars;
+    bool owned{};
+    std::vector<uint64_t> digits;
+    std::vector<uint64_t> symbols;
+    std::vector<uint64_t> gears;
+    std::vector<uint8_t> gearCounts;
+    std::vector<int64_t> gearProducts;
+  };
+
+  // Rows y - 1 and y + 1 are used if they were pushed
+  void scanRow(std::size_t y)
+  {
+    const std::size_t first = y == 0 ? 0 : y - 1;
+    const std::size_t last = std::min(y + 1, rows_ - 1);
+    auto& row = ring_[y % 3];
+
+    nearSymbol_.assign(words_, 0);
+    for (auto ny = first; ny <= last; ny++) {
+      orDilated(ring_[ny % 3].symbols, nearSymbol_);
+    }
+
+    forEachDigitRun(row.digits, [&](std::size_t begin, std::size_t end) {
+      // Halo rows miss the symbols of their outer neighbor, but only their gear contributions are used and every
+      // number next to a gear is a part number
+      bool partNumber = row.owned && anyBitInRange(nearSymbol_, begin, end);
+      int64_t number{};
+      for (auto x = begin; x < end; x++) {
+        number = (number * 10) + (row.chars[x] - '0');
+      }
+      if (partNumber) {
+        sums_.partNumbers += number;
+      }
+
+      for (auto ny = first; ny <= last; ny++) {
+        auto& gearRow = ring_[ny % 3];
+        if (!gearRow.owned) {
+          continue;
+        }
+        forEachBitInRange(gearRow.gears, begin == 0 ? 0 : begin - 1, std::min(end + 1, width_), [&](std::size_t x) {
+          // Only exactly two numbers make a gear, the count saturates past that
+          if (gearRow.gearCounts[x] < 2) {
+            gearRow.gearProducts[x] *= number;
+          }
+          gearRow.gearCounts[x] = static_cast<uint8_t>(std::min(gearRow.gearCounts[x] + 1, 3));
+        });
+      }
+    });
+  }
+
+  void finishGears(std::size_t y)
+  {
+    const auto& row = ring_[y % 3];
+    for (std::size_t x = 0; x < width_; x++) {
+      if (row.gearCounts[x] == 2) {
+        sums_.gearRatios += row.gearProducts[x];
+      }
+    }
+  }
+
+  std::size_t width_;
+  std::size_t words_;
+  std::array<Row, 3> ring_;
+  std::vector<uint64_t> nearSymbol_;
+  std::size_t rows_{0};
+  SchematicSums sums_;
+};
+
+SchematicSums scanSchematic(Lines lines)
+{
+  AOC_PROFILE_FUNCTION();
+  std::size_t width = 0;
+  for (auto line : lines) {
+    width = std::max(width, line.size());
+  }
+  SchematicScanner scanner(width);
+  for (auto line : lines) {
+    scanner.push(line);
+  }
+  return scanner.finish();
+}
+
+// Horizontal bands of bandRows rows, each scanned on its own core with one halo row above and below. Band sums
+// are merged in band order.
+SchematicSums scanSchematicBands(Lines lines, std::size_t bandRows = 512)
+{
+  AOC_PROFILE_FUNCTION();
+  std::size_t width = 0;
+  for (auto line : lines) {
+    width = std::max(width, line.size());
+  }
+  bandRows = std::max<std::size_t>(bandRows, 1);
+  const auto bands = (lines.size() + bandRows - 1) / bandRows;
+  return parallelTransformReduce(
+      v::iota(std::size_t{0}, bands), SchematicSums{},
+      [](SchematicSums a, SchematicSums b) {
+        return SchematicSums{.partNumbers = a.partNumbers + b.partNumbers, .gearRatios = a.gearRatios + b.gearRatios};
+      },
+      [&](std::size_t band) {
+        const auto begin = band * bandRows;
+        const auto end = std::min(begin + bandRows, lines.size());
+        SchematicScanner scanner(width);
+        if (begin > 0) {
+          scanner.push(lines[begin - 1], false);
+        }
+        for (auto y = begin; y < end; y++) {
+          scanner.push(lines[y]);
+        }
+        if (end < lines.size()) {
+          scanner.push(lines[end], false);
+        }
+        return scanner.finish();
+      },
+      1);
+}
+
+// Single pass over the input with memory for three rows
+std::pair<int64_t, int64_t> solveStreaming(const std::filesystem::path& path,
+                                           std::size_t bufferSize = LineStream::defaultBufferSize)
+{
+  std::optional<SchematicScanner> scanner;
+  forEachLine(
+      path,
+      [&scanner](std::string_view line) {
+        if (!scanner) {
+          scanner.emplace(line.size());
+        }
+        scanner->push(line);
+      },
+      bufferSize);
+  if (!scanner) {
+    return {};
+  }
+  auto sums = scanner->finish();
+  return {sums.partNumbers, sums.gearRatios};
+}
+
+// Entry point of the aoc runner
+Answers solve(const MappedInput& input, TaskSelection tasks)
+{
+  // Both tasks come out of the same pass, which profiles as scanSchematicBands
+  auto sums = scanSchematicBands(input.lines());
+  Answers answers;
+  if (tasks.task1) {
+    answers.task1 = sums.partNumbers;
+  }
+  if (tasks.task2) {
+    answers.task2 = sums.gearRatios;
+  }
+  return answers;
+}
+}  // namespace day3
+
+#ifdef AOC_TESTS
+using namespace day3;
+
 TEST_CASE("Task1 Tests")
 {
-  std::vector<std::string> input = {
+  std::vector<std::string_view> input = {
       "467..114..", "...*......", "..35..633.", "......#...", "617*......",
       ".....+.58.", "..592.....", "......755.", "...$.*....", ".664.598..",
   };
 
+  auto grid = parseSchematic(input);
   int64_t sumGearRatios{};
-  std::vector<int64_t> partNumbers = getPartNumbers(input, sumGearRatios);
+  std::vector<int64_t> partNumbers = getPartNumbers(grid, sumGearRatios);
   REQUIRE(partNumbers == std::vector<int64_t>{467, 35, 633, 617, 592, 755, 664, 598});
-  REQUIRE(task1(input) == 4361);
+  REQUIRE(task1(grid) == 4361);
   REQUIRE(sumGearRatios == 467835);
+  REQUIRE(scanSchematic(input) == SchematicSums{.partNumbers = 4361, .gearRatios = 467835});
+}
+
+TEST_CASE("Bitmap engine matches the grid walk")
+{
+  // Rows wider than a mask word, numbers touching the row ends and word borders
+  for (std::size_t width : {10, 63, 64, 65, 140, 200}) {
+    SeededRng rng(width);
+    std::vector<std::string> rows(60, std::string(width, '.'));
+    for (auto& row : rows) {
+      for (auto& c : row) {
+        auto roll = rng.index(20);
+        c = roll < 6 ? static_cast<char>('0' + rng.index(10)) : roll == 6 ? '*' : roll == 7 ? '#' : '.';
+      }
+    }
+    std::vector<std::string_view> lines(rows.begin(), rows.end());
+
+    int64_t sumGearRatios{};
+    auto partNumbers = getPartNumbers(parseSchematic(lines), sumGearRatios);
+    auto partNumberSum = std::reduce(partNumbers.begin(), partNumbers.end());
+    const SchematicSums expected{.partNumbers = partNumberSum, .gearRatios = sumGearRatios};
+    REQUIRE(scanSchematic(lines) == expected);
+    for (std::size_t bandRows : {1, 2, 7, 100}) {
+      REQUIRE(scanSchematicBands(lines, bandRows) == expected);
+    }
+
+    TempFile file("aoc_day3_stream_test");
+    {
+      std::ofstream out(file.path());
+      for (const auto& row : rows) {
+        out << row << '\n';
+      }
+    }
+    REQUIRE(solveStreaming(file.path(), 16) == std::pair{expected.partNumbers, expected.gearRatios});
+  }
 }
 
 TEST_CASE("Task1")
 {
-  auto input = readLines("../../day3/input.txt");
-  std::cout << std::format("Day2 Task1 result: {}\n", task1(input));
+  MappedInput input("../../day3/input.txt");
+  std::cout << std::format("Day2 Task1 result: {}\n", task1(parseSchematic(input.lines())));
 }
 
 TEST_CASE("Task2")
 {
-  auto input = readLines("../../day3/input.txt");
-  std::cout << std::format("Day2 Task2 result: {}\n", task2(input));
+  MappedInput input("../../day3/input.txt");
+  std::cout << std::format("Day2 Task2 result: {}\n", task2(parseSchematic(input.lines())));
+}
+
+TEST_CASE("Benchmark", "[.benchmark]")
+{
+  const std::filesystem::path path = benchmarkInputPath("day3");
+  MappedInput input(path);
+  Benchmark bench("day3", input);
+  bench.run("read", [&] { return MappedInput(path); });
+  auto grid = bench.run("parse", [&] { return parseSchematic(input.lines()); });
+  bench.run("task1", [&] { return task1(grid); });
+  bench.run("task2", [&] { return task2(grid); });
+  bench.run("bitmap engine", [&] { return scanSchematic(input.lines()); });
+  bench.run("bands", [&] { return scanSchematicBands(input.lines()); });
+  bench.run("stream", [&] { return solveStreaming(path); });
 }
+#endif  // AOC_TESTS
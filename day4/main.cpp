@@ -1,24 +1,143 @@
 #include "common.hpp"
+#include "integer_scanner.hpp"
+#include "profile.hpp"
+#include "small_vector.hpp"
+#include "solvers.hpp"
 
-#include <catch2/catch_test_macros.hpp>
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <filesystem>
 #include <fmt/format.h>
+#include <fstream>
+#include <initializer_list>
 #include <iostream>
+#include <limits>
 #include <numeric>
 #include <ranges>
-#include <scn/scan.h>
-#include <set>
+#include <span>
 #include <stdexcept>
 #include <string_view>
-#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#ifdef AOC_TESTS
+#include "bench.hpp"
+#include "generators.hpp"
+#include "temp_file.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+#endif
 
 namespace r = std::ranges;
 namespace v = std::ranges::views;
 
+namespace day4
+{
+
+// Set of non-negative card numbers as a bitmap. Numbers below 128, which covers real inputs, live in two inline
+// words; larger numbers spill into further words, up to maxNumber.
+class NumberSet
+{
+public:
+  // Bounds the bitmap to 8 KiB per set, far above anything a real card holds
+  static constexpr int64_t maxNumber = 65535;
+
+  NumberSet() = default;
+
+  NumberSet(std::initializer_list<int> numbers)
+  {
+    for (auto number : numbers) {
+      insert(number);
+    }
+  }
+
+  void insert(int64_t number)
+  {
+    if (number < 0) {
+      throw std::runtime_error("Negative card number!");
+    }
+    if (number > maxNumber) {
+      throw std::runtime_error("Card number out of range!");
+    }
+    auto word = static_cast<std::size_t>(number) / 64;
+    while (words_.size() <= word) {
+      words_.push_back(0);
+    }
+    words_[word] |= uint64_t{1} << (number % 64);
+  }
+
+  bool contains(int number) const
+  {
+    auto word = static_cast<std::size_t>(number) / 64;
+    return number >= 0 && word < words_.size() && ((words_[word] >> (number % 64)) & 1) != 0;
+  }
+
+  std::size_t size() const
+  {
+    std::size_t count{};
+    for (auto word : words_) {
+      count += static_cast<std::size_t>(std::popcount(word));
+    }
+    return count;
+  }
+
+  // popcount(*this & other)
+  std::size_t commonCount(const NumberSet& other) const
+  {
+    std::size_t count{};
+    for (std::size_t i = 0; i < std::min(words_.size(), other.words_.size()); i++) {
+      count += static_cast<std::size_t>(std::popcount(words_[i] & other.words_[i]));
+    }
+    return count;
+  }
+
+  // Words only grow as far as the largest number needs, so equal sets have equal words
+  bool operator==(const NumberSet&) const = default;
+
+private:
+  SmallVector<uint64_t, 2> words_;
+};
+
+// Points and copy counts double with every match, both throw instead of wrapping around past int64_t
+int64_t checkedAdd(int64_t a, int64_t b)
+{
+  int64_t sum{};
+#if defined(__GNUC__) || defined(__clang__)
+  if (__builtin_add_overflow(a, b, &sum)) {
+    throw std::overflow_error("Card count does not fit into int64_t!");
+  }
+#else
+  constexpr auto max = std::numeric_limits<int64_t>::max();
+  constexpr auto min = std::numeric_limits<int64_t>::min();
+  if ((b > 0 && a > max - b) || (b < 0 && a < min - b)) {
+    throw std::overflow_error("Card count does not fit into int64_t!");
+  }
+  sum = a + b;
+#endif
+  return sum;
+}
+
+int64_t pointsFor(int matches)
+{
+  if (matches > 63) {
+    throw std::overflow_error("Card points do not fit into int64_t!");
+  }
+  return matches == 0 ? 0 : int64_t{1} << (matches - 1);
+}
+
 struct Card
 {
   int id{-1};
-  std::unordered_set<int> winning;
-  std::set<int> present;
+  NumberSet winning;
+  NumberSet present;
+  // Numbers on both sides, computed once by fromStr
+  int matchCount{};
 
   static Card fromStr(std::string_view v);
 
@@ -26,85 +145,290 @@ struct Card
 
   int64_t calculatePoints() const
   {
-    int matches{};
-    for (auto p : present) {
-      if (winning.contains(p)) {
-        matches++;
-      }
-    }
-    if (matches == 0) {
-      return 0;
-    }
-    return static_cast<int64_t>(1) << (matches - 1);
+    return pointsFor(matchCount);
   }
 
   int64_t matches() const
   {
-    int matches{};
-    for (auto p : present) {
-      if (winning.contains(p)) {
-        matches++;
-      }
-    }
-    if (matches == 0) {
-      return 0;
-    }
-    return matches;
+    return matchCount;
   }
 };
 
+// Positions of the colon and the bar of a card line, throws for malformed lines
+std::pair<std::size_t, std::size_t> cardSeparators(std::string_view v)
+{
+  auto colon = v.find(':');
+  if (!v.starts_with("Card") || colon == std::string_view::npos) {
+    throw std::runtime_error("Error parsing card id!");
+  }
+  auto separator = v.find('|', colon);
+  if (separator == std::string_view::npos) {
+    throw std::runtime_error("Wrong separator?");
+  }
+  return {colon, separator};
+}
+
 Card Card::fromStr(std::string_view v)
 {
   Card card;
-
-  scn::ranges::subrange input(v);
-  auto result = scn::scan<int>(v, "Card {}: ");
-  if (result) {
-    card.id = result->value();
-    input = result->range();
-  } else {
+  auto [colon, separator] = cardSeparators(v);
+  std::array<int64_t, 1> id{};
+  if (scanIntegers(v.substr(0, colon), std::span(id)) != 1) {
     throw std::runtime_error("Error parsing card id!");
   }
-  scn::ranges::subrange range(v);
+  if (id[0] < 0 || id[0] > std::numeric_limits<int>::max()) {
+    throw std::runtime_error("Card id out of range!");
+  }
+  card.id = static_cast<int>(id[0]);
 
-  while (auto result = scn::scan_value<int>(input)) {
-    card.winning.insert(result->value());
-    input = result->range();
+  // insert rejects numbers past NumberSet::maxNumber, like parseCardMasks rejects numbers past 127
+  forEachInteger(v.substr(colon + 1, separator - colon - 1), [&card](int64_t number) { card.winning.insert(number); });
+  forEachInteger(v.substr(separator + 1), [&card](int64_t number) { card.present.insert(number); });
+  card.matchCount = static_cast<int>(card.winning.commonCount(card.present));
+
+  return card;
+}
+
+std::vector<Card> parseCards(Lines lines)
+{
+  return parallelTransform(lines, [](std::string_view line) { return Card::fromStr(line); });
+}
+
+// Batched path for huge card lists: the numbers below 128 of both sides of a chunk of cards are stored as
+// structure of arrays and counted four cards at a time (AVX2 nibble lookup popcount, std::popcount otherwise).
+// Cards with larger numbers go through Card::fromStr.
+struct CardMasks
+{
+  std::vector<uint64_t> winningLow;
+  std::vector<uint64_t> winningHigh;
+  std::vector<uint64_t> presentLow;
+  std::vector<uint64_t> presentHigh;
+
+  explicit CardMasks(std::size_t cards)
+      : winningLow(cards), winningHigh(cards), presentLow(cards), presentHigh(cards)
+  {
   }
+};
 
-  if (auto result = scn::scan<std::string_view>(input, "{}"); result && result->value() == std::string_view{"|"}) {
-    input = result->range();
-  } else {
-    throw std::runtime_error("Wrong separator?");
+// Collects the numbers of both sides into 128 bit masks, false if a number does not fit
+bool parseCardMasks(std::string_view v, uint64_t& winningLow, uint64_t& winningHigh, uint64_t& presentLow,
+                    uint64_t& presentHigh)
+{
+  auto [colon, separator] = cardSeparators(v);
+  bool fits = true;
+  auto collect = [&fits](std::string_view numbers, uint64_t& low, uint64_t& high) {
+    forEachInteger(numbers, [&](int64_t number) {
+      if (number < 0 || number >= 128) {
+        fits = false;
+      } else if (number < 64) {
+        low |= uint64_t{1} << number;
+      } else {
+        high |= uint64_t{1} << (number - 64);
+      }
+    });
+  };
+  collect(v.substr(colon + 1, separator - colon - 1), winningLow, winningHigh);
+  collect(v.substr(separator + 1), presentLow, presentHigh);
+  return fits;
+}
+
+// Match count of a single card line, for the streaming path
+int cardMatches(std::string_view line)
+{
+  uint64_t winningLow{};
+  uint64_t winningHigh{};
+  uint64_t presentLow{};
+  uint64_t presentHigh{};
+  if (!parseCardMasks(line, winningLow, winningHigh, presentLow, presentHigh)) {
+    return Card::fromStr(line).matchCount;
   }
+  return std::popcount(winningLow & presentLow) + std::popcount(winningHigh & presentHigh);
+}
+
+#if defined(__AVX2__)
+// Population count of each 64 bit lane
+inline __m256i popcount64(__m256i v)
+{
+  const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 0, 1, 1, 2, 1, 2, 2, 3, 1, 2,
+                                          2, 3, 2, 3, 3, 4);
+  const __m256i lowNibbles = _mm256_set1_epi8(0x0F);
+  __m256i low = _mm256_shuffle_epi8(lookup, _mm256_and_si256(v, lowNibbles));
+  __m256i high = _mm256_shuffle_epi8(lookup, _mm256_and_si256(_mm256_srli_epi16(v, 4), lowNibbles));
+  return _mm256_sad_epu8(_mm256_add_epi8(low, high), _mm256_setzero_si256());
+}
+#endif
 
-  while (auto result = scn::scan_value<int>(input)) {
-    card.present.insert(result->value());
-    input = result->range();
+// out[i] = popcount(winning_i & present_i)
+void countMatches(const CardMasks& masks, std::span<int> out)
+{
+  std::size_t i = 0;
+#if defined(__AVX2__)
+  auto load = [](const std::vector<uint64_t>& column, std::size_t i) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(column.data() + i));
+  };
+  for (; i + 4 <= out.size(); i += 4) {
+    __m256i low = _mm256_and_si256(load(masks.winningLow, i), load(masks.presentLow, i));
+    __m256i high = _mm256_and_si256(load(masks.winningHigh, i), load(masks.presentHigh, i));
+    alignas(32) std::array<uint64_t, 4> counts{};
+    _mm256_store_si256(reinterpret_cast<__m256i*>(counts.data()), _mm256_add_epi64(popcount64(low), popcount64(high)));
+    for (std::size_t j = 0; j < 4; j++) {
+      out[i + j] = static_cast<int>(counts[j]);
+    }
+  }
+#endif
+  for (; i < out.size(); i++) {
+    out[i] = std::popcount(masks.winningLow[i] & masks.presentLow[i]) +
+             std::popcount(masks.winningHigh[i] & masks.presentHigh[i]);
   }
+}
 
-  return card;
+// Match count of every card, in input order
+std::vector<int> batchMatchCounts(Lines lines)
+{
+  std::vector<int> matchCounts(lines.size());
+  WorkStealingPool::global().forEachChunk(lines.size(), 4096, [&](std::size_t begin, std::size_t end) {
+    CardMasks masks(end - begin);
+    std::vector<std::size_t> wideCards;
+    for (auto i = begin; i < end; i++) {
+      auto j = i - begin;
+      if (!parseCardMasks(lines[i], masks.winningLow[j], masks.winningHigh[j], masks.presentLow[j],
+                          masks.presentHigh[j])) {
+        wideCards.push_back(i);
+      }
+    }
+    countMatches(masks, std::span(matchCounts).subspan(begin, end - begin));
+    for (auto i : wideCards) {
+      matchCounts[i] = Card::fromStr(lines[i]).matchCount;
+    }
+  });
+  return matchCounts;
 }
 
-std::vector<int> getCardCounts(const std::vector<Card>& cards)
+int64_t sumPoints(std::span<const int> matchCounts)
 {
-  std::vector<int> cardCounts(cards.size(), 1);
+  return std::accumulate(matchCounts.begin(), matchCounts.end(), int64_t{0}, [](int64_t sum, int matches) {
+    return checkedAdd(sum, pointsFor(matches));
+  });
+}
+
+// Both tasks in one pass over the match counts in card order. Card i hands its copies to the next matches cards,
+// a range add that is recorded on a difference array. Only the entries of the next maxMatches + 1 cards can be
+// non-zero, so the array is a ring buffer that grows with the largest match count seen. O(1) per card.
+class CardPropagator
+{
+public:
+  // Returns the number of copies of this card, the original included
+  int64_t push(int matches)
+  {
+    auto span = static_cast<std::size_t>(matches) + 2;
+    if (span > delta_.size()) {
+      grow(span);
+    }
+    running_ = checkedAdd(running_, std::exchange(delta_[head_], 0));
+    auto copies = checkedAdd(running_, 1);
+    if (matches > 0) {
+      auto& first = delta_[(head_ + 1) % delta_.size()];
+      first = checkedAdd(first, copies);
+      auto& last = delta_[(head_ + static_cast<std::size_t>(matches) + 1) % delta_.size()];
+      last = checkedAdd(last, -copies);
+      points_ = checkedAdd(points_, pointsFor(matches));
+    }
+    head_ = (head_ + 1) % delta_.size();
+    cards_ = checkedAdd(cards_, copies);
+    return copies;
+  }
+
+  int64_t points() const
+  {
+    return points_;
+  }
 
-  for (std::size_t i = 0; i < cards.size(); i++) {
-    auto matches = cards[i].matches();
-    auto incValue = cardCounts[i];
-    for (std::size_t j = i + 1; j < std::min<std::size_t>(i + matches + 1, cards.size()); j++) {
-      cardCounts[j] += incValue;
+  // Total number of cards, copies included
+  int64_t cards() const
+  {
+    return cards_;
+  }
+
+private:
+  // Unrolls the ring so the current card lands at index 0
+  void grow(std::size_t span)
+  {
+    std::vector<int64_t> delta(std::max(span, 2 * delta_.size()));
+    for (std::size_t i = 0; i < delta_.size(); i++) {
+      delta[i] = delta_[(head_ + i) % delta_.size()];
     }
+    delta_ = std::move(delta);
+    head_ = 0;
   }
 
-  return cardCounts;
+  std::vector<int64_t> delta_;
+  std::size_t head_{};
+  int64_t running_{};
+  int64_t points_{};
+  int64_t cards_{};
+};
+
+std::vector<int64_t> getCardCounts(std::span<const int> matchCounts)
+{
+  CardPropagator propagator;
+  return toVector(matchCounts | v::transform([&propagator](int matches) { return propagator.push(matches); }));
+}
+
+std::vector<int64_t> getCardCounts(std::span<const Card> cards)
+{
+  auto matchCounts = toVector(cards | v::transform(&Card::matchCount));
+  return getCardCounts(matchCounts);
 }
 
+// Single pass over the input with memory bounded by the largest match count
+std::pair<int64_t, int64_t> solveStreaming(const std::filesystem::path& path,
+                                           std::size_t bufferSize = LineStream::defaultBufferSize)
+{
+  CardPropagator propagator;
+  forEachLine(
+      path,
+      [&propagator](std::string_view line) {
+        if (!line.empty()) {
+          propagator.push(cardMatches(line));
+        }
+      },
+      bufferSize);
+  return {propagator.points(), propagator.cards()};
+}
+
+// Entry point of the aoc runner
+Answers solve(const MappedInput& input, TaskSelection tasks)
+{
+  auto matchCounts = [&input] {
+    AOC_PROFILE_ZONE("parse");
+    return batchMatchCounts(input.lines());
+  }();
+  // Both tasks come out of the same pass
+  CardPropagator propagator;
+  {
+    AOC_PROFILE_ZONE("propagate");
+    for (auto matches : matchCounts) {
+      propagator.push(matches);
+    }
+  }
+  Answers answers;
+  if (tasks.task1) {
+    answers.task1 = propagator.points();
+  }
+  if (tasks.task2) {
+    answers.task2 = propagator.cards();
+  }
+  return answers;
+}
+}  // namespace day4
+
+#ifdef AOC_TESTS
+using namespace day4;
+
 TEST_CASE("Task1 and 2 example input")
 {
   // clang-format off
-  std::vector<std::string> input = {
+  std::vector<std::string_view> input = {
     "Card 1: 41 48 83 86 17 | 83 86  6 31 17  9 48 53",
     "Card 2: 13 32 20 16 61 | 61 30 68 82 17 32 24 19",
     "Card 3:  1 21 53 59 44 | 69 82 63 72 16 21 14  1",
@@ -114,11 +438,10 @@ TEST_CASE("Task1 and 2 example input")
   };
   // clang-format off
 
-  auto v = input | v::transform(Card::fromStr);
-  std::vector<Card> cards(v.begin(), v.end());
+  auto cards = parseCards(input);
 
-  REQUIRE(cards[0] == Card{.id = 1, .winning={41,48,83,86,17}, .present = {83,86,6,31,17,9,48,53}});
-  REQUIRE(cards[5] == Card{.id = 6, .winning={31,18,13,56,72}, .present = {74,77,10,23,35,67,36,11}});
+  REQUIRE(cards[0] == Card{.id = 1, .winning={41,48,83,86,17}, .present = {83,86,6,31,17,9,48,53}, .matchCount = 4});
+  REQUIRE(cards[5] == Card{.id = 6, .winning={31,18,13,56,72}, .present = {74,77,10,23,35,67,36,11}, .matchCount = 0});
 
   REQUIRE(cards[0].calculatePoints() == 8);
   REQUIRE(cards[1].calculatePoints() == 2);
@@ -132,22 +455,141 @@ TEST_CASE("Task1 and 2 example input")
 
   auto cardCounts = getCardCounts(cards);
   REQUIRE(std::reduce(cardCounts.begin(), cardCounts.end()) == 30);
+
+  auto matchCounts = batchMatchCounts(input);
+  REQUIRE(matchCounts == std::vector{4, 2, 2, 1, 0, 0});
+  REQUIRE(sumPoints(matchCounts) == 13);
+
+  TempFile file("aoc_day4_stream_test");
+  {
+    std::ofstream out(file.path());
+    for (auto line : input) {
+      out << line << '\n';
+    }
+  }
+  // Buffer smaller than a line forces refills and buffer growth
+  REQUIRE(solveStreaming(file.path(), 16) == std::pair<int64_t, int64_t>{13, 30});
+}
+
+TEST_CASE("Card propagation")
+{
+  // Growing match counts force the ring buffer to grow mid-stream, long runs of ten matches overflow int
+  std::vector<int> matchCounts;
+  for (int i = 0; i < 60; i++) {
+    matchCounts.push_back(i < 20 ? i % 7 : 10);
+  }
+
+  std::vector<int64_t> expected(matchCounts.size(), 1);
+  for (std::size_t i = 0; i < matchCounts.size(); i++) {
+    for (std::size_t j = i + 1; j < std::min<std::size_t>(i + matchCounts[i] + 1, matchCounts.size()); j++) {
+      expected[j] += expected[i];
+    }
+  }
+
+  auto cardCounts = getCardCounts(matchCounts);
+  REQUIRE(cardCounts == expected);
+  REQUIRE(cardCounts.back() > std::numeric_limits<int>::max());
+
+  // Ten matches per card roughly double the copies every card, the total passes 2^63 well before card 100
+  std::vector<int> exploding(100, 10);
+  REQUIRE_THROWS_AS(getCardCounts(exploding), std::overflow_error);
+  REQUIRE_THROWS_AS(sumPoints(std::vector{64}), std::overflow_error);
+  REQUIRE(sumPoints(std::vector{63}) == int64_t{1} << 62);
+
+  TempFile file("aoc_day4_overflow_test");
+  {
+    std::ofstream out(file.path());
+    for (int card = 1; card <= 100; card++) {
+      out << "Card " << card << ": 1 2 3 4 5 6 7 8 9 10 | 1 2 3 4 5 6 7 8 9 10\n";
+    }
+  }
+  REQUIRE_THROWS_AS(solveStreaming(file.path()), std::overflow_error);
+  REQUIRE_THROWS_AS(solve(MappedInput(file.path()), {}), std::overflow_error);
+}
+
+TEST_CASE("Batched match counts")
+{
+  auto text = generateToString([](std::ostream& out) { generateDay4(out, {.cards = 10000}, 17); });
+  auto lines = splitLines(text);
+  // Numbers past 128 take the fallback path
+  lines.push_back("Card 10001: 200 5 70 | 200 70 1");
+  lines.push_back("Card 10002: 1000 | 1000");
+
+  auto matchCounts = batchMatchCounts(lines);
+  REQUIRE(matchCounts.size() == lines.size());
+  for (std::size_t i = 0; i < lines.size(); i++) {
+    REQUIRE(matchCounts[i] == Card::fromStr(lines[i]).matchCount);
+  }
+  REQUIRE(matchCounts[10000] == 2);
+  REQUIRE(matchCounts[10001] == 1);
+  REQUIRE(Card::fromStr(lines[10001]).winning.contains(1000));
+
+  // Numbers past the bitmap limit (or past int) are rejected instead of truncated or allocating huge sets
+  REQUIRE(Card::fromStr("Card 1: 65535 | 65535").matchCount == 1);
+  REQUIRE_THROWS_AS(Card::fromStr("Card 1: 65536 | 1"), std::runtime_error);
+  REQUIRE_THROWS_AS(Card::fromStr("Card 1: 1 | 99999999999"), std::runtime_error);
+  REQUIRE_THROWS_AS(Card::fromStr("Card 99999999999: 1 | 1"), std::runtime_error);
+  REQUIRE_THROWS_AS(batchMatchCounts(std::vector<std::string_view>{"Card 1: 4294967297 | 1"}), std::runtime_error);
+}
+
+TEST_CASE("Generated input")
+{
+  // Same input as aoc_gen day4 at scale 1 and the default seed
+  TempFile file("aoc_day4_generated_test");
+  {
+    std::ofstream out(file.path());
+    generateDay4(out, {.cards = 200}, 1);
+  }
+  MappedInput input(file.path());
+  auto matchCounts = batchMatchCounts(input.lines());
+  REQUIRE(matchCounts.size() == 200);
+
+  std::vector<int64_t> expected(matchCounts.size(), 1);
+  for (std::size_t i = 0; i < matchCounts.size(); i++) {
+    for (std::size_t j = i + 1; j < std::min<std::size_t>(i + matchCounts[i] + 1, matchCounts.size()); j++) {
+      expected[j] += expected[i];
+    }
+  }
+  auto cards = std::reduce(expected.begin(), expected.end());
+
+  auto answers = solve(input, {});
+  REQUIRE(answers.task2 == cards);
+  REQUIRE(*answers.task2 > 0);
+  REQUIRE(solveStreaming(file.path()).second == cards);
 }
 
 TEST_CASE("Task1")
 {
-  auto input = readLines("../../day4/input.txt");
-  auto v = input | v::transform(Card::fromStr);
-  std::vector<Card> cards(v.begin(), v.end());
-  std::cout << std::format("Day4 Task1 result: {}\n", std::accumulate(v.begin(), v.end(), static_cast<int64_t>(0), [](int64_t p, const Card& card){ return p + card.calculatePoints(); }));
+  MappedInput input("../../day4/input.txt");
+  auto cards = parseCards(input.lines());
+  std::cout << std::format("Day4 Task1 result: {}\n", std::accumulate(cards.begin(), cards.end(), static_cast<int64_t>(0), [](int64_t p, const Card& card){ return p + card.calculatePoints(); }));
 }
 
 TEST_CASE("Task2")
 {
-  auto input = readLines("../../day4/input.txt");
-  auto v = input | v::transform(Card::fromStr);
-  std::vector<Card> cards(v.begin(), v.end());
+  MappedInput input("../../day4/input.txt");
+  auto cards = parseCards(input.lines());
   auto cardCounts = getCardCounts(cards);
   auto sum = std::reduce(cardCounts.begin(), cardCounts.end());
   std::cout << std::format("Day4 Task1 result: {}\n", sum);
 }
+
+TEST_CASE("Benchmark", "[.benchmark]")
+{
+  const std::filesystem::path path = benchmarkInputPath("day4");
+  MappedInput input(path);
+  Benchmark bench("day4", input);
+  bench.run("read", [&] { return MappedInput(path); });
+  auto cards = bench.run("parse", [&] { return parseCards(input.lines()); });
+  bench.run("batched matches", [&] { return batchMatchCounts(input.lines()); });
+  bench.run("task1", [&] {
+    return std::accumulate(cards.begin(), cards.end(), static_cast<int64_t>(0),
+                           [](int64_t p, const Card& card) { return p + card.calculatePoints(); });
+  });
+  bench.run("task2", [&] {
+    auto cardCounts = getCardCounts(cards);
+    return std::reduce(cardCounts.begin(), cardCounts.end());
+  });
+  bench.run("stream", [&] { return solveStreaming(path); });
+}
+#endif  // AOC_TESTS
@@ -1,8 +1,15 @@
 #include "common.hpp"
+#include "integer_scanner.hpp"
+#include "profile.hpp"
+#include "solvers.hpp"
 
-#include <catch2/catch_test_macros.hpp>
+#include <algorithm>
+#include <array>
+#include <bit>
 #include <cctype>
+#include <chrono>
 #include <cstdint>
+#include <filesystem>
 #include <fmt/core.h>
 #include <fmt/format.h>
 #include <iostream>
@@ -13,14 +20,30 @@
 #include <ranges>
 #include <scn/scan.h>
 #include <set>
+#include <span>
 #include <stdexcept>
+#include <string>
 #include <string_view>
 #include <unordered_set>
 #include <vector>
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#ifdef AOC_TESTS
+#include "bench.hpp"
+#include "generators.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+#endif
+
 namespace r = std::ranges;
 namespace v = std::ranges::views;
 
+namespace day5
+{
+
 struct MappingRange
 {
   int64_t dstStart{-1};
@@ -38,73 +61,71 @@ struct Range
   int64_t length{-1};
 };
 
+// One "X-to-Y map:" block, ranges sorted by srcStart
+struct Stage
+{
+  std::string source;
+  std::string destination;
+  MappingRanges ranges;
+
+  bool operator==(const Stage&) const = default;
+};
+
 struct Almanac
 {
   std::vector<int64_t> seeds;
 
-  MappingRanges seedToSoil;
-  MappingRanges soilToFertilizer;
-  MappingRanges fertilizerToWater;
-  MappingRanges waterToLight;
-  MappingRanges lightToTemperature;
-  MappingRanges temperatureToHumidity;
-  MappingRanges humidityToLocationMap;
+  // In input order, every stage maps the destination category of the one before it
+  std::vector<Stage> stages;
 
-  static Almanac fromStr(const std::vector<std::string> v);
+  static Almanac fromStr(Lines v);
 
   static int64_t getIndexIntoMap(int64_t index, const MappingRanges& mapping);
   static void getRangesIntoMap(Range index, const MappingRanges& mapping, std::vector<Range>& mappedRanges);
 };
 
-Almanac Almanac::fromStr(const std::vector<std::string> v)
+Almanac Almanac::fromStr(Lines v)
 {
   Almanac almanac;
 
   // Seeds
-  {
-    scn::ranges::subrange r = v[0];
-    if (auto result = scn::scan<>(r, "seeds: ")) {
-      r = result->range();
-    } else {
-      throw std::runtime_error("Failed to parse seeds!");
-    }
-
-    while (auto result = scn::scan<int64_t>(r, "{}")) {
-      almanac.seeds.push_back(result->value());
-      r = result->range();
-    }
+  if (v.empty() || !v[0].starts_with("seeds:")) {
+    throw std::runtime_error("Failed to parse seeds!");
   }
+  scanIntegers(v[0], almanac.seeds);
 
-  std::size_t cursor = 2;
-  auto parseMap = [&](std::string_view name, auto& vec) {
-    if (auto result = scn::scan<std::string_view>(v[cursor++], "{} map:"); !result || result->value() != name) {
-      if (result) {
-        fmt::println("Wrong key: {}", result->value());
-      }
+  for (std::size_t cursor = 1; cursor < v.size();) {
+    if (v[cursor].empty()) {
+      cursor++;
+      continue;
+    }
 
+    auto result = scn::scan<std::string_view>(v[cursor++], "{} map:");
+    if (!result) {
       throw std::runtime_error("Wrong header of map?");
     }
+    auto name = result->value();
+    auto separator = name.find("-to-");
+    if (separator == std::string_view::npos) {
+      throw std::runtime_error("Wrong header of map?");
+    }
+    auto& stage = almanac.stages.emplace_back(Stage{.source = std::string(name.substr(0, separator)),
+                                                    .destination = std::string(name.substr(separator + 4)),
+                                                    .ranges = {}});
+    if (almanac.stages.size() > 1 && almanac.stages[almanac.stages.size() - 2].destination != stage.source) {
+      throw std::runtime_error(fmt::format("Map {} does not continue the previous one?", name));
+    }
 
-    while (auto result = scn::scan<int64_t, int64_t, int64_t>(v[cursor++], "{} {} {}")) {
-      auto& vals = result->values();
-      vec.emplace_back(MappingRange{get<0>(vals), get<1>(vals), get<2>(vals)});
-
-      if (cursor >= v.size()) {
-        break;
-      }
+    // The map ends at the first line that is not "dst src length", usually the empty separator row
+    std::array<int64_t, 3> values{};
+    while (cursor < v.size() && scanIntegers(v[cursor], std::span(values)) == values.size()) {
+      stage.ranges.emplace_back(MappingRange{values[0], values[1], values[2]});
+      cursor++;
     }
 
-    std::sort(vec.begin(), vec.end(),
+    std::sort(stage.ranges.begin(), stage.ranges.end(),
               [](const MappingRange& a, const MappingRange& b) { return a.srcStart < b.srcStart; });
-  };
-
-  parseMap("seed-to-soil", almanac.seedToSoil);
-  parseMap("soil-to-fertilizer", almanac.soilToFertilizer);
-  parseMap("fertilizer-to-water", almanac.fertilizerToWater);
-  parseMap("water-to-light", almanac.waterToLight);
-  parseMap("light-to-temperature", almanac.lightToTemperature);
-  parseMap("temperature-to-humidity", almanac.temperatureToHumidity);
-  parseMap("humidity-to-location", almanac.humidityToLocationMap);
+  }
 
   return almanac;
 }
@@ -122,6 +143,7 @@ int64_t Almanac::getIndexIntoMap(int64_t index, const MappingRanges& mapping)
 
 void Almanac::getRangesIntoMap(Range index, const MappingRanges& mapping, std::vector<Range>& mappedRanges)
 {
+  AOC_PROFILE_FUNCTION();
   // This assumes the mappings are sorted by srcStart
   int64_t cursor = index.start;
   int64_t end = index.start + index.length;
@@ -159,24 +181,196 @@ void Almanac::getRangesIntoMap(Range index, const MappingRanges& mapping, std::v
   }
 }
 
+// Piecewise linear map over the non-negative numbers: x in [starts[i], starts[i + 1]) maps to x + offsets[i], the
+// last segment is unbounded. starts[0] is always 0, almanac values are never negative.
+struct PiecewiseMap
+{
+  std::vector<int64_t> starts{0};
+  std::vector<int64_t> offsets{0};
+
+  // Ranges sorted by srcStart, where ranges overlap the first one wins like in getIndexIntoMap
+  static PiecewiseMap fromRanges(const MappingRanges& ranges);
+
+  // Segment holding x
+  std::size_t segment(int64_t x) const
+  {
+    return static_cast<std::size_t>(r::upper_bound(starts, x) - starts.begin()) - 1;
+  }
+
+  int64_t operator()(int64_t x) const
+  {
+    return x + offsets[segment(x)];
+  }
+
+  // next(*this(x)), built by merging the breakpoints of this map with those of next pulled back through it
+  PiecewiseMap then(const PiecewiseMap& next) const;
+
+  bool operator==(const PiecewiseMap&) const = default;
+
+private:
+  // Extends the last segment if the offset did not change
+  void append(int64_t start, int64_t offset);
+};
+
+void PiecewiseMap::append(int64_t start, int64_t offset)
+{
+  if (starts.back() == start) {
+    offsets.back() = offset;
+    if (starts.size() > 1 && offsets[offsets.size() - 2] == offset) {
+      starts.pop_back();
+      offsets.pop_back();
+    }
+  } else if (offsets.back() != offset) {
+    starts.push_back(start);
+    offsets.push_back(offset);
+  }
+}
+
+PiecewiseMap PiecewiseMap::fromRanges(const MappingRanges& ranges)
+{
+  PiecewiseMap map;
+  int64_t cursor = 0;
+  for (const auto& range : ranges) {
+    auto start = std::max(range.srcStart, cursor);
+    auto end = range.srcStart + range.length;
+    if (start >= end) {
+      continue;
+    }
+    map.append(start, range.dstStart - range.srcStart);
+    map.append(end, 0);
+    cursor = end;
+  }
+  return map;
+}
+
+PiecewiseMap PiecewiseMap::then(const PiecewiseMap& next) const
+{
+  PiecewiseMap composed;
+  for (std::size_t i = 0; i < starts.size(); i++) {
+    auto offset = offsets[i];
+    auto j = next.segment(starts[i] + offset);
+    composed.append(starts[i], offset + next.offsets[j]);
+    // Breakpoints of next inside the image of this segment, pulled back into its domain
+    for (j++; j < next.starts.size(); j++) {
+      auto start = next.starts[j] - offset;
+      if (i + 1 < starts.size() && start >= starts[i + 1]) {
+        break;
+      }
+      composed.append(start, offset + next.offsets[j]);
+    }
+  }
+  return composed;
+}
+
+// Read only copy of a PiecewiseMap for lookups, the breakpoints are stored in Eytzinger (breadth first) order. The
+// search descends with one comparison per level and no branch on its outcome, and the first levels share a few
+// cache lines for all lookups.
+class EytzingerMap
+{
+public:
+  explicit EytzingerMap(const PiecewiseMap& map)
+      : keys_(map.starts.size()), offsets_(map.starts.size())
+  {
+    // starts[0] == 0 is below every key, the tree holds the others and node 0 the last segment
+    std::size_t next = 1;
+    fill(map, next, 1);
+    offsets_[0] = map.offsets.back();
+  }
+
+  int64_t operator()(int64_t x) const
+  {
+    std::size_t k = 1;
+    while (k < keys_.size()) {
+      k = (2 * k) + static_cast<std::size_t>(keys_[k] <= x);
+    }
+    // Undoes the right turns taken after the last left one, k ends at the first key above x (0 if none)
+    k >>= std::countr_one(k) + 1;
+    return x + offsets_[k];
+  }
+
+private:
+  // In-order walk of the implicit tree hands out the sorted breakpoints
+  void fill(const PiecewiseMap& map, std::size_t& next, std::size_t k)
+  {
+    if (k >= keys_.size()) {
+      return;
+    }
+    fill(map, next, 2 * k);
+    keys_[k] = map.starts[next];
+    // x below this key lies in the segment before it
+    offsets_[k] = map.offsets[next - 1];
+    next++;
+    fill(map, next, (2 * k) + 1);
+  }
+
+  std::vector<int64_t> keys_;
+  std::vector<int64_t> offsets_;
+};
+
+// All stages composed into one map from the first category to the last
+PiecewiseMap compileAlmanac(const Almanac& a)
+{
+  AOC_PROFILE_FUNCTION();
+  PiecewiseMap compiled;
+  for (const auto& stage : a.stages) {
+    compiled = compiled.then(PiecewiseMap::fromRanges(stage.ranges));
+  }
+  return compiled;
+}
+
 int64_t task1(const Almanac& a)
 {
+  EytzingerMap seedToLocation(compileAlmanac(a));
+
   int64_t lowestLocation = std::numeric_limits<int64_t>::max();
+  for (auto seed : a.seeds) {
+    lowestLocation = std::min(lowestLocation, seedToLocation(seed));
+  }
+
+  return lowestLocation;
+}
 
-  for (auto index : a.seeds) {
-    index = Almanac::getIndexIntoMap(index, a.seedToSoil);
-    index = Almanac::getIndexIntoMap(index, a.soilToFertilizer);
-    index = Almanac::getIndexIntoMap(index, a.fertilizerToWater);
-    index = Almanac::getIndexIntoMap(index, a.waterToLight);
-    index = Almanac::getIndexIntoMap(index, a.lightToTemperature);
-    index = Almanac::getIndexIntoMap(index, a.temperatureToHumidity);
-    index = Almanac::getIndexIntoMap(index, a.humidityToLocationMap);
-    lowestLocation = std::min(lowestLocation, index);
+// Sorts the ranges and merges overlapping or touching ones, empty ranges are dropped
+void coalesce(std::vector<Range>& ranges)
+{
+  std::erase_if(ranges, [](const Range& range) { return range.length <= 0; });
+  r::sort(ranges, {}, &Range::start);
+  std::size_t merged = 0;
+  for (const auto& range : ranges) {
+    if (merged > 0 && range.start <= ranges[merged - 1].start + ranges[merged - 1].length) {
+      auto& last = ranges[merged - 1];
+      last.length = std::max(last.length, range.start + range.length - last.start);
+    } else {
+      ranges[merged++] = range;
+    }
+  }
+  ranges.resize(merged);
+}
+
+// Runs the ranges through all stages, coalescing after every one keeps them at most one per breakpoint
+int64_t lowestLocation(const Almanac& a, std::vector<Range> ranges)
+{
+  std::vector<Range> newRanges;
+  coalesce(ranges);
+  for (const auto& stage : a.stages) {
+    for (auto& r : ranges) {
+      Almanac::getRangesIntoMap(r, stage.ranges, newRanges);
+    }
+    std::swap(newRanges, ranges);
+    newRanges.clear();
+    coalesce(ranges);
   }
 
+  int64_t lowestLocation = std::numeric_limits<int64_t>::max();
+  for (auto& r : ranges) {
+    lowestLocation = std::min(lowestLocation, r.start);
+  }
   return lowestLocation;
 }
 
+// Seed ranges per parallel job, each chunk goes through the stages on its own
+constexpr std::size_t seedRangesPerChunk = 64;
+
 int64_t task2(const Almanac& a)
 {
   if (a.seeds.size() % 2 != 0)
@@ -187,35 +381,280 @@ int64_t task2(const Almanac& a)
     Range rng = {.start = a.seeds[i], .length = a.seeds[i + 1]};
     ranges.push_back(rng);
   }
-  std::vector<Range> newRanges;
 
-  auto handleMapping = [&](const auto& mappingTable) {
-    for (auto& r : ranges) {
-      Almanac::getRangesIntoMap(r, mappingTable, newRanges);
+  auto chunkCount = (ranges.size() + seedRangesPerChunk - 1) / seedRangesPerChunk;
+  return parallelTransformReduce(
+      v::iota(std::size_t{0}, chunkCount), std::numeric_limits<int64_t>::max(),
+      [](int64_t l, int64_t r) { return std::min(l, r); },
+      [&](std::size_t chunk) {
+        auto begin = chunk * seedRangesPerChunk;
+        auto end = std::min(begin + seedRangesPerChunk, ranges.size());
+        return lowestLocation(a, std::vector<Range>(ranges.begin() + static_cast<std::ptrdiff_t>(begin),
+                                                    ranges.begin() + static_cast<std::ptrdiff_t>(end)));
+      },
+      1);
+}
+
+// Both directions of a compiled almanac for many queries against one almanac. Every segment of the seed to location
+// map is inverted into a location interval with the seed interval it comes from. Sorted by location start, a
+// running maximum of their ends tells a backwards scan when no earlier interval can reach a query anymore, so a
+// query costs O(log M + k) for the usual almanacs whose segments do not map onto each other. For the forward
+// direction a sparse table over the lowest location of each segment answers range minima in O(1).
+class LocationIndex
+{
+public:
+  explicit LocationIndex(PiecewiseMap seedToLocation)
+      : map_(std::move(seedToLocation))
+  {
+    const auto segments = map_.starts.size();
+    for (std::size_t i = 0; i < segments; i++) {
+      auto offset = map_.offsets[i];
+      auto end = i + 1 < segments ? map_.starts[i + 1] + offset : std::numeric_limits<int64_t>::max();
+      preimages_.push_back(Preimage{.locationStart = map_.starts[i] + offset, .locationEnd = end, .offset = offset});
     }
-    std::swap(newRanges, ranges);
-    newRanges.clear();
+    r::sort(preimages_, {}, &Preimage::locationStart);
+    int64_t maxEnd = std::numeric_limits<int64_t>::min();
+    for (const auto& preimage : preimages_) {
+      maxEnd = std::max(maxEnd, preimage.locationEnd);
+      maxEnds_.push_back(maxEnd);
+    }
+
+    lowest_.emplace_back(segments);
+    for (std::size_t i = 0; i < segments; i++) {
+      lowest_[0][i] = map_.starts[i] + map_.offsets[i];
+    }
+    for (std::size_t width = 2; width <= segments; width *= 2) {
+      const auto& previous = lowest_.back();
+      std::vector<int64_t> level(segments - width + 1);
+      for (std::size_t i = 0; i < level.size(); i++) {
+        level[i] = std::min(previous[i], previous[i + (width / 2)]);
+      }
+      lowest_.push_back(std::move(level));
+    }
+  }
+
+  // Seeds whose location lies in [first, last], sorted and coalesced
+  std::vector<Range> seedsForLocations(int64_t first, int64_t last) const
+  {
+    std::vector<Range> seeds;
+    auto candidates = r::upper_bound(preimages_, last, {}, &Preimage::locationStart) - preimages_.begin();
+    for (auto i = candidates - 1; i >= 0 && maxEnds_[static_cast<std::size_t>(i)] > first; i--) {
+      const auto& preimage = preimages_[static_cast<std::size_t>(i)];
+      auto start = std::max(first, preimage.locationStart);
+      auto end = preimage.locationEnd - 1 < last ? preimage.locationEnd : last + 1;
+      if (start < end) {
+        seeds.push_back(Range{.start = start - preimage.offset, .length = end - start});
+      }
+    }
+    coalesce(seeds);
+    return seeds;
+  }
+
+  // Lowest location of a seed in [start, start + length), length > 0
+  int64_t lowestLocation(Range seeds) const
+  {
+    auto first = map_.segment(seeds.start);
+    auto last = map_.segment(seeds.start + seeds.length - 1);
+    auto lowest = seeds.start + map_.offsets[first];
+    if (first < last) {
+      // The segments after the first are covered from their start, their lowest location is where they begin
+      auto level = static_cast<std::size_t>(std::bit_width(last - first)) - 1;
+      lowest = std::min({lowest, lowest_[level][first + 1], lowest_[level][last + 1 - (std::size_t{1} << level)]});
+    }
+    return lowest;
+  }
+
+  int64_t lowestLocation(std::span<const Range> seeds) const
+  {
+    int64_t lowest = std::numeric_limits<int64_t>::max();
+    for (const auto& range : seeds) {
+      if (range.length > 0) {
+        lowest = std::min(lowest, lowestLocation(range));
+      }
+    }
+    return lowest;
+  }
+
+private:
+  struct Preimage
+  {
+    int64_t locationStart;
+    // Exclusive, INT64_MAX for the unbounded last segment
+    int64_t locationEnd;
+    // location - seed
+    int64_t offset;
   };
 
-  handleMapping(a.seedToSoil);
-  handleMapping(a.soilToFertilizer);
-  handleMapping(a.fertilizerToWater);
-  handleMapping(a.waterToLight);
-  handleMapping(a.lightToTemperature);
-  handleMapping(a.temperatureToHumidity);
-  handleMapping(a.humidityToLocationMap);
+  PiecewiseMap map_;
+  std::vector<Preimage> preimages_;
+  std::vector<int64_t> maxEnds_;
+  // lowest_[k][i] is the lowest location of the segments i .. i + 2^k - 1
+  std::vector<std::vector<int64_t>> lowest_;
+};
 
-  int64_t lowestLocation = std::numeric_limits<int64_t>::max();
-  for (auto& r : ranges) {
-    lowestLocation = std::min(lowestLocation, r.start);
+// Independent check of task2: every single seed of every seed range goes through the raw mapping ranges. Blocks of
+// eight seeds are tested against one range at a time without branches (two AVX2 registers, plain lane loops
+// otherwise), the seed ranges are cut into pieces that are spread over the WorkStealingPool.
+class SeedVerifier
+{
+public:
+  static constexpr std::size_t lanes = 8;
+
+  explicit SeedVerifier(const Almanac& a)
+  {
+    for (const auto& almanacStage : a.stages) {
+      auto& stage = stages_.emplace_back();
+      for (const auto& range : almanacStage.ranges) {
+        stage.starts.push_back(range.srcStart);
+        stage.ends.push_back(range.srcStart + range.length);
+        stage.deltas.push_back(range.dstStart - range.srcStart);
+      }
+    }
   }
-  return lowestLocation;
+
+  // Maps the values through all stages in place
+  void map(std::span<int64_t, lanes> values) const
+  {
+#if defined(__AVX2__)
+    auto* data = reinterpret_cast<__m256i*>(values.data());
+    __m256i low = _mm256_loadu_si256(data);
+    __m256i high = _mm256_loadu_si256(data + 1);
+    for (const auto& stage : stages_) {
+      // The first range holding a value wins, later ones are masked out
+      __m256i mappedLow = _mm256_setzero_si256();
+      __m256i mappedHigh = _mm256_setzero_si256();
+      __m256i addLow = _mm256_setzero_si256();
+      __m256i addHigh = _mm256_setzero_si256();
+      for (std::size_t i = 0; i < stage.starts.size(); i++) {
+        const __m256i start = _mm256_set1_epi64x(stage.starts[i]);
+        const __m256i end = _mm256_set1_epi64x(stage.ends[i]);
+        const __m256i delta = _mm256_set1_epi64x(stage.deltas[i]);
+        // start <= x < end <=> !(start > x) && end > x
+        __m256i insideLow = _mm256_andnot_si256(_mm256_or_si256(mappedLow, _mm256_cmpgt_epi64(start, low)),
+                                                _mm256_cmpgt_epi64(end, low));
+        __m256i insideHigh = _mm256_andnot_si256(_mm256_or_si256(mappedHigh, _mm256_cmpgt_epi64(start, high)),
+                                                 _mm256_cmpgt_epi64(end, high));
+        addLow = _mm256_add_epi64(addLow, _mm256_and_si256(insideLow, delta));
+        addHigh = _mm256_add_epi64(addHigh, _mm256_and_si256(insideHigh, delta));
+        mappedLow = _mm256_or_si256(mappedLow, insideLow);
+        mappedHigh = _mm256_or_si256(mappedHigh, insideHigh);
+      }
+      low = _mm256_add_epi64(low, addLow);
+      high = _mm256_add_epi64(high, addHigh);
+    }
+    _mm256_storeu_si256(data, low);
+    _mm256_storeu_si256(data + 1, high);
+#else
+    for (const auto& stage : stages_) {
+      std::array<int64_t, lanes> add{};
+      std::array<int64_t, lanes> mapped{};
+      for (std::size_t i = 0; i < stage.starts.size(); i++) {
+        for (std::size_t lane = 0; lane < lanes; lane++) {
+          // All ones if the value is inside and not mapped yet
+          int64_t inside = -static_cast<int64_t>(values[lane] >= stage.starts[i] && values[lane] < stage.ends[i]);
+          inside &= ~mapped[lane];
+          add[lane] += inside & stage.deltas[i];
+          mapped[lane] |= inside;
+        }
+      }
+      for (std::size_t lane = 0; lane < lanes; lane++) {
+        values[lane] += add[lane];
+      }
+    }
+#endif
+  }
+
+  // Lowest location of the seeds [start, start + length), length > 0
+  int64_t lowestLocation(int64_t start, int64_t length) const
+  {
+    int64_t lowest = std::numeric_limits<int64_t>::max();
+    std::array<int64_t, lanes> block{};
+    for (int64_t base = start; base < start + length; base += lanes) {
+      // The tail of the last block repeats its last seed
+      for (std::size_t lane = 0; lane < lanes; lane++) {
+        block[lane] = std::min(base + static_cast<int64_t>(lane), start + length - 1);
+      }
+      map(block);
+      lowest = std::min(lowest, r::min(block));
+    }
+    return lowest;
+  }
+
+private:
+  struct Stage
+  {
+    std::vector<int64_t> starts;
+    std::vector<int64_t> ends;
+    std::vector<int64_t> deltas;
+  };
+
+  std::vector<Stage> stages_;
+};
+
+struct VerificationResult
+{
+  int64_t lowestLocation{};
+  int64_t seeds{};
+  double seconds{};
+
+  double seedsPerSecond() const
+  {
+    return seconds > 0 ? static_cast<double>(seeds) / seconds : 0.0;
+  }
+};
+
+// task2 by brute force, pieceSize seeds make up one parallel job
+VerificationResult verifyTask2(const Almanac& a, int64_t pieceSize = int64_t{1} << 20)
+{
+  AOC_PROFILE_FUNCTION();
+  if (a.seeds.size() % 2 != 0)
+    throw std::runtime_error("Only even seed count allowed!");
+
+  auto begin = std::chrono::steady_clock::now();
+  VerificationResult result;
+  std::vector<Range> pieces;
+  for (std::size_t i = 0; i < a.seeds.size(); i += 2) {
+    for (int64_t offset = 0; offset < a.seeds[i + 1]; offset += pieceSize) {
+      pieces.push_back(Range{.start = a.seeds[i] + offset, .length = std::min(pieceSize, a.seeds[i + 1] - offset)});
+    }
+    result.seeds += std::max<int64_t>(a.seeds[i + 1], 0);
+  }
+
+  SeedVerifier verifier(a);
+  result.lowestLocation = parallelTransformReduce(
+      pieces, std::numeric_limits<int64_t>::max(), [](int64_t l, int64_t r) { return std::min(l, r); },
+      [&verifier](const Range& piece) { return verifier.lowestLocation(piece.start, piece.length); }, 1);
+  result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+  return result;
+}
+
+// Entry point of the aoc runner
+Answers solve(const MappedInput& input, TaskSelection tasks)
+{
+  auto almanac = [&input] {
+    AOC_PROFILE_ZONE("parse");
+    return Almanac::fromStr(input.lines());
+  }();
+  Answers answers;
+  if (tasks.task1) {
+    AOC_PROFILE_ZONE("task1");
+    answers.task1 = task1(almanac);
+  }
+  if (tasks.task2) {
+    AOC_PROFILE_ZONE("task2");
+    answers.task2 = task2(almanac);
+  }
+  return answers;
 }
+}  // namespace day5
+
+#ifdef AOC_TESTS
+using namespace day5;
 
 TEST_CASE("Task1 and 2 example input")
 {
   // clang-format off
-  std::vector<std::string> input = {
+  std::vector<std::string_view> input = {
     "seeds: 79 14 55 13",
     "", "seed-to-soil map:",
     "50 98 2",
@@ -254,16 +693,198 @@ TEST_CASE("Task1 and 2 example input")
   auto almanac = Almanac::fromStr(input);
 
   REQUIRE(almanac.seeds == std::vector<int64_t>{79, 14, 55, 13});
-  REQUIRE(almanac.humidityToLocationMap == std::vector{MappingRange{60, 56, 37}, MappingRange{56, 93, 4}});
+  REQUIRE(almanac.stages.size() == 7);
+  REQUIRE(almanac.stages[0].source == "seed");
+  REQUIRE(almanac.stages.back().destination == "location");
+  REQUIRE(almanac.stages.back().ranges == std::vector{MappingRange{60, 56, 37}, MappingRange{56, 93, 4}});
 
   REQUIRE(task1(almanac) == 35);
   REQUIRE(task2(almanac) == 46);
+  REQUIRE(verifyTask2(almanac, 5).lowestLocation == 46);
+}
+
+TEST_CASE("Compiled almanac")
+{
+  auto text = generateToString([](std::ostream& out) {
+    generateDay5(out, {.mappingsPerStage = 60, .valueRange = int64_t{1} << 20}, 5);
+  });
+  auto almanac = Almanac::fromStr(splitLines(text));
+  auto chain = [&almanac](int64_t index) {
+    for (const auto& stage : almanac.stages) {
+      index = Almanac::getIndexIntoMap(index, stage.ranges);
+    }
+    return index;
+  };
+
+  auto compiled = compileAlmanac(almanac);
+  EytzingerMap lookup(compiled);
+  REQUIRE(r::is_sorted(compiled.starts));
+  // Every breakpoint and its neighbors, plus a sweep over the whole value range and beyond
+  std::vector<int64_t> probes;
+  for (auto start : compiled.starts) {
+    probes.insert(probes.end(), {start - 1, start, start + 1});
+  }
+  for (int64_t x = 0; x < (int64_t{1} << 21); x += 97) {
+    probes.push_back(x);
+  }
+  for (auto x : probes) {
+    if (x >= 0) {
+      REQUIRE(compiled(x) == chain(x));
+      REQUIRE(lookup(x) == chain(x));
+    }
+  }
+
+  // Overlapping sources, the first range wins
+  auto overlapping = PiecewiseMap::fromRanges({{100, 10, 10}, {200, 15, 10}});
+  REQUIRE(overlapping(12) == 102);
+  REQUIRE(overlapping(22) == 207);
+  REQUIRE(overlapping(30) == 30);
+}
+
+TEST_CASE("Brute force verifier")
+{
+  auto text = generateToString([](std::ostream& out) {
+    generateDay5(out, {.seedRanges = 6, .mappingsPerStage = 30, .valueRange = int64_t{1} << 18}, 11);
+  });
+  auto almanac = Almanac::fromStr(splitLines(text));
+
+  SeedVerifier verifier(almanac);
+  std::array<int64_t, SeedVerifier::lanes> block{0, 1, 17, 4096, 65535, 100000, 200001, 262143};
+  auto expected = block;
+  for (auto& x : expected) {
+    for (const auto& stage : almanac.stages) {
+      x = Almanac::getIndexIntoMap(x, stage.ranges);
+    }
+  }
+  verifier.map(block);
+  REQUIRE(block == expected);
+
+  auto result = verifyTask2(almanac, 1000);
+  REQUIRE(result.lowestLocation == task2(almanac));
+  int64_t seeds = 0;
+  for (std::size_t i = 1; i < almanac.seeds.size(); i += 2) {
+    seeds += almanac.seeds[i];
+  }
+  REQUIRE(result.seeds == seeds);
+}
+
+TEST_CASE("Generic stage chain")
+{
+  // clang-format off
+  std::vector<std::string_view> input = {
+    "seeds: 0 10 20 5",
+    "",
+    "seed-to-a map:",
+    "100 0 5",
+    "",
+    "a-to-location map:",
+    "0 102 3",
+    "50 20 5",
+  };
+  // clang-format on
+
+  auto almanac = Almanac::fromStr(input);
+  REQUIRE(almanac.stages.size() == 2);
+  REQUIRE(almanac.stages[0].destination == "a");
+  REQUIRE(almanac.stages[1].source == "a");
+  REQUIRE(task1(almanac) == 5);
+  REQUIRE(task2(almanac) == 0);
+  REQUIRE(verifyTask2(almanac).lowestLocation == 0);
+
+  std::vector<std::string_view> broken = {"seeds: 1 2", "", "seed-to-a map:", "1 2 3", "", "b-to-c map:", "1 2 3"};
+  REQUIRE_THROWS(Almanac::fromStr(broken));
+
+  std::vector<Range> ranges = {{5, 3}, {0, 2}, {2, 1}, {10, 0}, {7, 2}};
+  coalesce(ranges);
+  REQUIRE(ranges.size() == 2);
+  REQUIRE((ranges[0].start == 0 && ranges[0].length == 3));
+  REQUIRE((ranges[1].start == 5 && ranges[1].length == 4));
+
+  // Enough seed ranges for several parallel chunks
+  auto text = generateToString([](std::ostream& out) {
+    generateDay5(out, {.seedRanges = 300, .mappingsPerStage = 20, .valueRange = int64_t{1} << 16}, 3);
+  });
+  auto generated = Almanac::fromStr(splitLines(text));
+  REQUIRE(task2(generated) == verifyTask2(generated).lowestLocation);
+}
+
+TEST_CASE("Location index")
+{
+  constexpr int64_t valueRange = int64_t{1} << 12;
+  auto text = generateToString([](std::ostream& out) {
+    generateDay5(out, {.seedRanges = 8, .mappingsPerStage = 25, .valueRange = valueRange}, 23);
+  });
+  auto almanac = Almanac::fromStr(splitLines(text));
+  auto compiled = compileAlmanac(almanac);
+  LocationIndex index(compiled);
+
+  std::vector<int64_t> locations;
+  for (int64_t seed = 0; seed < 2 * valueRange; seed++) {
+    locations.push_back(compiled(seed));
+  }
+
+  SeededRng rng(99);
+  for (int query = 0; query < 200; query++) {
+    auto first = rng.uniform(0, valueRange);
+    auto last = first + rng.uniform(0, valueRange / 4);
+    auto seeds = index.seedsForLocations(first, last);
+    REQUIRE(r::is_sorted(seeds, {}, &Range::start));
+    // Compared within the part of the seed axis enumerated above
+    std::vector<int64_t> expected;
+    for (int64_t seed = 0; seed < 2 * valueRange; seed++) {
+      if (locations[static_cast<std::size_t>(seed)] >= first && locations[static_cast<std::size_t>(seed)] <= last) {
+        expected.push_back(seed);
+      }
+    }
+    std::vector<int64_t> found;
+    for (const auto& range : seeds) {
+      for (auto seed = range.start; seed < std::min(range.start + range.length, 2 * valueRange); seed++) {
+        found.push_back(seed);
+      }
+    }
+    REQUIRE(found == expected);
+
+    auto start = rng.uniform(0, valueRange);
+    Range seedRange{.start = start, .length = rng.uniform(1, valueRange)};
+    auto lowest = *std::min_element(locations.begin() + start, locations.begin() + start + seedRange.length);
+    REQUIRE(index.lowestLocation(seedRange) == lowest);
+  }
+
+  std::vector<Range> seedRanges;
+  for (std::size_t i = 0; i < almanac.seeds.size(); i += 2) {
+    seedRanges.push_back(Range{.start = almanac.seeds[i], .length = almanac.seeds[i + 1]});
+  }
+  REQUIRE(index.lowestLocation(seedRanges) == task2(almanac));
+}
+
+TEST_CASE("Verify task2", "[.verify]")
+{
+  MappedInput lines("../../day5/input.txt");
+  auto almanac = Almanac::fromStr(lines.lines());
+  auto result = verifyTask2(almanac);
+  fmt::println("Day5 Task2 brute force: {} ({} seeds in {:.2f} s, {})", result.lowestLocation, result.seeds,
+               result.seconds, formatRate(result.seedsPerSecond(), "seeds"));
+  REQUIRE(result.lowestLocation == task2(almanac));
 }
 
 TEST_CASE("Tasks")
 {
-  auto input = Almanac::fromStr(readLines("../../day5/input.txt"));
+  MappedInput lines("../../day5/input.txt");
+  auto input = Almanac::fromStr(lines.lines());
   std::cout << std::format("Day5 Task1 result: {}\n", task1(input));
   std::cout << std::format("Day5 Task2 result: {}\n", task2(input));
 }
 
+TEST_CASE("Benchmark", "[.benchmark]")
+{
+  const std::filesystem::path path = benchmarkInputPath("day5");
+  MappedInput input(path);
+  Benchmark bench("day5", input);
+  bench.run("read", [&] { return MappedInput(path); });
+  auto almanac = bench.run("parse", [&] { return Almanac::fromStr(input.lines()); });
+  bench.run("compile", [&] { return compileAlmanac(almanac); });
+  bench.run("location index", [&] { return LocationIndex(compileAlmanac(almanac)).lowestLocation(Range{0, 1}); });
+  bench.run("task1", [&] { return task1(almanac); });
+  bench.run("task2", [&] { return task2(almanac); });
+}
+#endif  // AOC_TESTS
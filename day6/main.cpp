@@ -1,35 +1,53 @@
 #include "common.hpp"
+#include "integer_scanner.hpp"
+#include "profile.hpp"
+#include "solvers.hpp"
 
 #include <algorithm>
-#include <catch2/catch_test_macros.hpp>
+#include <array>
 #include <cctype>
-#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
 #include <fmt/core.h>
 #include <fmt/format.h>
+#include <limits>
 #include <ranges>
 #include <scn/scan.h>
+#include <span>
+#include <stdexcept>
 #include <string>
 #include <string_view>
+#include <utility>
 #include <vector>
 
+#if !defined(__SIZEOF_INT128__) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#ifdef AOC_TESTS
+#include "bench.hpp"
+#include "generators.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+#include <charconv>
+#endif
+
 namespace r = std::ranges;
 namespace v = std::ranges::views;
 
-std::vector<int64_t> strToList(std::string v)
+namespace day6
 {
-  auto r = v | v::split(' ') | v::drop(1) | v::filter([](auto&& rng) { return !rng.empty(); }) |
-           v::transform([](auto&& rng) {
-             std::string_view v(rng);
-             int64_t i{};
-             std::from_chars(v.begin(), v.end(), i);
-             return i;
-           });
-  std::vector<int64_t> list(r.begin(), r.end());
 
+std::vector<int64_t> strToList(std::string_view v)
+{
+  // The label in front of the numbers contains no digits
+  std::vector<int64_t> list;
+  scanIntegers(v, list);
   return list;
 }
 
-int64_t parseTask2(std::string v)
+int64_t parseTask2(std::string_view v)
 {
   auto r = v | v::filter([](char c) { return std::isdigit(c); });
   std::string numbers(r.begin(), r.end());
@@ -37,29 +55,100 @@ int64_t parseTask2(std::string v)
   return std::stoll(numbers);
 }
 
+// hold * (duration - hold) > distance for 0 <= hold <= duration, the product is formed in 128 bits and never
+// overflows
+bool beatsRecord(int64_t hold, int64_t duration, int64_t distance)
+{
+  if (distance < 0) {
+    return true;
+  }
+  auto speed = static_cast<uint64_t>(hold);
+  auto timeToDrive = static_cast<uint64_t>(duration - hold);
+#if defined(__SIZEOF_INT128__)
+  __extension__ using UInt128 = unsigned __int128;
+  return static_cast<UInt128>(speed) * timeToDrive > static_cast<uint64_t>(distance);
+#elif defined(_M_X64)
+  uint64_t high{};
+  uint64_t low = _umul128(speed, timeToDrive, &high);
+  return high != 0 || low > static_cast<uint64_t>(distance);
+#else
+  uint64_t high = __umulh(speed, timeToDrive);
+  return high != 0 || speed * timeToDrive > static_cast<uint64_t>(distance);
+#endif
+}
+
+// Hold times 1 .. duration - 1 that travel further than distance. The winning holds are the integers between the
+// roots of t * (duration - t) = distance and lie symmetric around duration / 2, so only the first one is needed.
+// It is estimated from the cancellation free form of the lower root, 2 * distance / (T + sqrt(T^2 - 4 * distance)),
+// and corrected with exact comparisons, which takes a step or two at most. Constant time per race.
 int64_t numbersToBeatRecord(int64_t duration, int64_t distance)
 {
-  int64_t count{};
-  for (int64_t time = 1; time < duration; time++) {
-    int64_t speed = time;
-    int64_t timeToDrive = duration - time;
-    if (speed * timeToDrive > distance)
-      count++;
+  if (duration < 2) {
+    return 0;
+  }
+  auto half = duration / 2;
+  if (!beatsRecord(half, duration, distance)) {
+    return 0;
+  }
+  if (distance < 0) {
+    return duration - 1;
   }
 
-  return count;
+  auto time = static_cast<long double>(duration);
+  auto discriminant = (time * time) - (4.0L * static_cast<long double>(distance));
+  auto estimate = (2.0L * static_cast<long double>(distance)) / (time + std::sqrt(std::max(discriminant, 0.0L)));
+  auto first = std::clamp(static_cast<int64_t>(estimate), int64_t{1}, half);
+  while (first > 1 && beatsRecord(first - 1, duration, distance)) {
+    first--;
+  }
+  while (!beatsRecord(first, duration, distance)) {
+    first++;
+  }
+  return duration - (2 * first) + 1;
+}
+
+// Batch path for many races, spread over the WorkStealingPool
+std::vector<int64_t> numbersToBeatRecord(std::span<const int64_t> durations, std::span<const int64_t> distances)
+{
+  if (durations.size() != distances.size()) {
+    throw std::runtime_error("Time and distance count differ");
+  }
+  return parallelTransform(
+      v::iota(std::size_t{0}, durations.size()),
+      [&](std::size_t i) { return numbersToBeatRecord(durations[i], distances[i]); }, 4096);
 }
 
 int64_t task1(const std::vector<int64_t>& durations, const std::vector<int64_t>& distances)
 {
   int64_t result = 0;
-  for (std::size_t i = 0; i < durations.size(); i++) {
-    int64_t count = numbersToBeatRecord(durations[i], distances[i]);
+  for (auto count : numbersToBeatRecord(durations, distances)) {
     result = result == 0 ? count : result * count;
   }
   return result;
 }
 
+// Entry point of the aoc runner
+Answers solve(const MappedInput& input, TaskSelection tasks)
+{
+  if (input.size() < 2) {
+    throw std::runtime_error("Invalid input, expected a time and a distance line");
+  }
+  Answers answers;
+  if (tasks.task1) {
+    AOC_PROFILE_ZONE("task1");
+    answers.task1 = task1(strToList(input[0]), strToList(input[1]));
+  }
+  if (tasks.task2) {
+    AOC_PROFILE_ZONE("task2");
+    answers.task2 = task1({parseTask2(input[0])}, {parseTask2(input[1])});
+  }
+  return answers;
+}
+}  // namespace day6
+
+#ifdef AOC_TESTS
+using namespace day6;
+
 TEST_CASE("Task1 and 2 example input")
 {
   // clang-format off
@@ -82,11 +171,141 @@ TEST_CASE("Task1 and 2 example input")
 
   REQUIRE(parseTask2(input[0]) == 71530);
   REQUIRE(parseTask2(input[1]) == 940200);
+  REQUIRE(numbersToBeatRecord(71530, 940200) == 71503);
+}
+
+TEST_CASE("Integer scanner")
+{
+  // Reference: every digit run parsed with from_chars, negated if a '-' directly precedes it
+  auto reference = [](std::string_view text) {
+    std::vector<int64_t> values;
+    for (std::size_t i = 0; i < text.size();) {
+      if (!std::isdigit(static_cast<unsigned char>(text[i]))) {
+        i++;
+        continue;
+      }
+      auto start = i;
+      while (i < text.size() && std::isdigit(static_cast<unsigned char>(text[i]))) {
+        i++;
+      }
+      int64_t value{};
+      REQUIRE(std::from_chars(text.data() + start, text.data() + i, value).ec == std::errc{});
+      values.push_back(start > 0 && text[start - 1] == '-' ? -value : value);
+    }
+    return values;
+  };
+
+  SeededRng rng(6);
+  constexpr std::string_view separators[] = {" ", "  ", "\n", ",", ": ", "-", "--", "a-", "x", "+"};
+  for (int round = 0; round < 2000; round++) {
+    std::string text;
+    // Sizes around one to four 64 byte windows, runs land on every offset of a window border
+    auto size = static_cast<std::size_t>(rng.uniform(0, 260));
+    while (text.size() < size) {
+      text += separators[rng.index(std::size(separators))];
+      // Mostly short runs, the rest covers the 8 digit, 9-16 digit and scalar parse paths up to 19 digits
+      auto digits = rng.chance(0.5) ? rng.uniform(1, 4) : rng.uniform(1, 19);
+      for (int64_t d = 0; d < digits; d++) {
+        // The first of 19 digits stays below 9, so every run fits into int64_t
+        auto highest = digits == 19 && d == 0 ? 8 : 9;
+        text += static_cast<char>('0' + rng.uniform(0, highest));
+      }
+    }
+    // Exact sized heap copy, so reads past the end are caught by sanitizers; most texts end mid-number
+    std::vector<char> buffer(text.begin(), text.end());
+    std::string_view view(buffer.data(), buffer.size());
+
+    auto expected = reference(view);
+    std::vector<int64_t> values;
+    REQUIRE(scanIntegers(view, values) == expected.size());
+    REQUIRE(values == expected);
+
+    std::array<int64_t, 4> prefix{};
+    auto count = scanIntegers(view, std::span(prefix));
+    REQUIRE(count == expected.size());
+    for (std::size_t i = 0; i < std::min(count, prefix.size()); i++) {
+      REQUIRE(prefix[i] == expected[i]);
+    }
+
+    // Full windows take the SIMD mask path, the tail the scalar one
+    for (std::size_t base = 0; base < view.size(); base += 64) {
+      auto length = std::min<std::size_t>(64, view.size() - base);
+      uint64_t digits = 0;
+      uint64_t minus = 0;
+      for (std::size_t i = 0; i < length; i++) {
+        digits |= static_cast<uint64_t>(std::isdigit(static_cast<unsigned char>(view[base + i])) != 0) << i;
+        minus |= static_cast<uint64_t>(view[base + i] == '-') << i;
+      }
+      REQUIRE(scanner_detail::digitMask(view.data() + base, length) == digits);
+      REQUIRE(scanner_detail::byteMask(view.data() + base, length, '-') == minus);
+    }
+  }
+
+  // Every run length at the very end of the text, with and without sign
+  std::string digits = "1234567890123456789";
+  for (std::size_t length = 1; length <= digits.size(); length++) {
+    for (std::string_view prefix : {"", "-", "x-", "7 -"}) {
+      std::string text = std::string(prefix) + digits.substr(0, length);
+      std::vector<char> buffer(text.begin(), text.end());
+      std::vector<int64_t> values;
+      scanIntegers(std::string_view(buffer.data(), buffer.size()), values);
+      REQUIRE(values == reference(text));
+    }
+  }
+
+  // Values outside of int64_t throw instead of wrapping around, leading zeros do not count
+  std::vector<int64_t> values;
+  REQUIRE_NOTHROW(scanIntegers("9223372036854775807 -9223372036854775807 000000000000000000000042", values));
+  constexpr int64_t max = std::numeric_limits<int64_t>::max();
+  REQUIRE(values == std::vector<int64_t>{max, -max, 42});
+  REQUIRE_THROWS_AS(scanIntegers("9223372036854775808", values), std::out_of_range);
+  REQUIRE_THROWS_AS(scanIntegers("1 654340568007941058040715 2", values), std::out_of_range);
+}
+
+TEST_CASE("Closed form")
+{
+  auto loop = [](int64_t duration, int64_t distance) {
+    int64_t count{};
+    for (int64_t time = 1; time < duration; time++) {
+      count += static_cast<int64_t>(time * (duration - time) > distance);
+    }
+    return count;
+  };
+  for (int64_t duration = 0; duration < 120; duration++) {
+    for (int64_t distance = -3; distance <= (duration * duration / 4) + 2; distance++) {
+      REQUIRE(numbersToBeatRecord(duration, distance) == loop(duration, distance));
+    }
+  }
+
+  // Products far beyond 64 bit
+  constexpr int64_t large = int64_t{1} << 62;
+  // Holds 1 and 2 fall short, 3 * (2^62 - 3) exceeds INT64_MAX
+  REQUIRE(numbersToBeatRecord(large, std::numeric_limits<int64_t>::max()) == large - 5);
+  REQUIRE(numbersToBeatRecord(int64_t{1} << 32, ((int64_t{1} << 31) * (int64_t{1} << 31)) - 1) == 1);
+  REQUIRE(numbersToBeatRecord(int64_t{1} << 32, (int64_t{1} << 31) * (int64_t{1} << 31)) == 0);
+  REQUIRE(numbersToBeatRecord((int64_t{1} << 32) + 1, (int64_t{1} << 31) * ((int64_t{1} << 31) + 1) - 1) == 2);
+  for (int64_t distance : {int64_t{0}, int64_t{1}, int64_t{1000}, int64_t{1} << 40}) {
+    auto count = numbersToBeatRecord(large + 1, distance);
+    auto first = ((large + 1) - count + 1) / 2;
+    REQUIRE(beatsRecord(first, large + 1, distance));
+    REQUIRE(!beatsRecord(first - 1, large + 1, distance));
+  }
+
+  std::vector<int64_t> durations;
+  std::vector<int64_t> distances;
+  for (int64_t i = 0; i < 10000; i++) {
+    durations.push_back(2 + (i % 97));
+    distances.push_back((i * 7) % (durations.back() * durations.back() / 4));
+  }
+  auto counts = numbersToBeatRecord(durations, distances);
+  for (std::size_t i = 0; i < counts.size(); i++) {
+    REQUIRE(counts[i] == loop(durations[i], distances[i]));
+  }
 }
 
 TEST_CASE("Tasks")
 {
-  auto input = readLines("../../day6/input.txt");
+  MappedInput input("../../day6/input.txt");
   {
     std::vector<int64_t> times = strToList(input[0]);
     std::vector<int64_t> distances = strToList(input[1]);
@@ -100,3 +319,16 @@ TEST_CASE("Tasks")
     fmt::println("Day5 Task2 result: {}\n", task1({times}, {distances}));
   }
 }
+
+TEST_CASE("Benchmark", "[.benchmark]")
+{
+  const std::filesystem::path path = benchmarkInputPath("day6");
+  MappedInput input(path);
+  Benchmark bench("day6", input);
+  bench.run("read", [&] { return MappedInput(path); });
+  auto [times, distances] = bench.run("parse", [&] { return std::pair(strToList(input[0]), strToList(input[1])); });
+  bench.run("task1", [&] { return task1(times, distances); });
+  auto [time, distance] = bench.run("parse2", [&] { return std::pair(parseTask2(input[0]), parseTask2(input[1])); });
+  bench.run("task2", [&] { return task1({time}, {distance}); });
+}
+#endif  // AOC_TESTS
@@ -1,13 +1,18 @@
 #include "common.hpp"
+#include "profile.hpp"
+#include "solvers.hpp"
 
 #include <algorithm>
-#include <catch2/catch_test_macros.hpp>
+#include <array>
 #include <cctype>
 #include <charconv>
+#include <cstdint>
+#include <filesystem>
 #include <fmt/core.h>
 #include <fmt/format.h>
+#include <functional>
 #include <iterator>
-#include <map>
+#include <numeric>
 #include <ranges>
 #include <scn/scan.h>
 #include <stdexcept>
@@ -15,9 +20,43 @@
 #include <string_view>
 #include <vector>
 
+#ifdef AOC_TESTS
+#include "bench.hpp"
+#include "generators.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+#endif
+
 namespace r = std::ranges;
 namespace v = std::ranges::views;
 
+namespace day7
+{
+
+// Rank of every card character, -1 for anything that is no card
+constexpr std::array<int8_t, 256> cardRanks = [] {
+  std::array<int8_t, 256> ranks{};
+  ranks.fill(-1);
+  constexpr std::string_view order = "23456789TJQKA";
+  for (std::size_t i = 0; i < order.size(); i++) {
+    ranks[static_cast<unsigned char>(order[i])] = static_cast<int8_t>(i);
+  }
+  return ranks;
+}();
+
+constexpr int jokerRank = 9;
+
+// Sort key of a hand: the strength class in bits 20 and up, below it the five card ranks as 4 bit digits, first
+// card first. Comparing keys compares hands, and the hex digits of a key read like the hand.
+constexpr uint32_t packKey(int strengthClass, const std::array<int, 5>& ranks)
+{
+  auto key = static_cast<uint32_t>(strengthClass);
+  for (auto rank : ranks) {
+    key = (key << 4) | static_cast<uint32_t>(rank);
+  }
+  return key;
+}
+
 struct CardBidPair
 {
   std::array<int, 5> cards{};
@@ -25,28 +64,31 @@ struct CardBidPair
   int64_t bid{-1};
   int strengthClass{};
   int strengthClassTask2{};
+  uint32_t key{};
+  // Jokers rank below every other card
+  uint32_t keyTask2{};
 
   bool operator==(const CardBidPair&) const = default;
 
   static CardBidPair fromStr(std::string_view v)
   {
-    auto r = v | v::split(' ') | v::transform([](auto&& rng) { return std::string_view(rng); });
+    if (v.size() < 7 || v[5] != ' ') {
+      throw std::runtime_error("Expected five cards and a bid");
+    }
     CardBidPair result;
-    result.cardsRaw = *r.begin();
-    std::unordered_map<char, int> cardLUT = {{'A', 12}, {'K', 11}, {'Q', 10}, {'J', 9}, {'T', 8}, {'9', 7}, {'8', 6},
-                                             {'7', 5},  {'6', 4},  {'5', 3},  {'4', 2}, {'3', 1}, {'2', 0}};
-    auto cardValues = result.cardsRaw | v::transform([&](char c) { return cardLUT[c]; });
-    if (cardValues.size() != 5) {
-      throw std::runtime_error("Too many cards");
+    result.cardsRaw = v.substr(0, 5);
+    for (std::size_t i = 0; i < result.cards.size(); i++) {
+      result.cards[i] = cardRanks[static_cast<unsigned char>(v[i])];
+      if (result.cards[i] < 0) {
+        throw std::runtime_error("Invalid card");
+      }
     }
-    std::copy(cardValues.begin(), cardValues.end(), result.cards.begin());
 
-    auto r2 = r | v::drop(1) | v::transform([](auto&& rng) {
-                int64_t v{-1};
-                std::from_chars(rng.begin(), rng.end(), v);
-                return v;
-              });
-    result.bid = *r2.begin();
+    auto bid = v.substr(6);
+    if (auto [end, error] = std::from_chars(bid.data(), bid.data() + bid.size(), result.bid);
+        error != std::errc{} || end != bid.data() + bid.size()) {
+      throw std::runtime_error("Invalid bid");
+    }
 
     // Calculate strength class
     auto getClass = [](const std::array<int, 13>& counts) {
@@ -69,88 +111,115 @@ struct CardBidPair
 
     std::array<int, 13> counts{};
     for (auto c : result.cards) {
-      counts.at(c)++;
+      counts[static_cast<std::size_t>(c)]++;
     }
     result.strengthClass = getClass(counts);
     // Task 2
-    int jokerCount = r::count(result.cards, cardLUT['J']);
+    int jokerCount = counts[jokerRank];
     // We should transform joker into the other most frequent card
     if (jokerCount == 5) {
       result.strengthClassTask2 = result.strengthClass;
     } else {
       // Remove jokers from counts and add them to most frequent type
-      counts[cardLUT['J']] = 0;
+      counts[jokerRank] = 0;
       (*r::max_element(counts)) += jokerCount;
       result.strengthClassTask2 = getClass(counts);
     }
 
+    result.key = packKey(result.strengthClass, result.cards);
+    std::array<int, 5> ranksTask2{};
+    r::transform(result.cards, ranksTask2.begin(), [](int rank) { return rank == jokerRank ? 0 : rank + 1; });
+    result.keyTask2 = packKey(result.strengthClassTask2, ranksTask2);
+
     return result;
   }
 };
 
-bool rankCards(CardBidPair& c1, CardBidPair& c2)
+bool rankCards(const CardBidPair& c1, const CardBidPair& c2)
 {
-  if (c1.strengthClass < c2.strengthClass)
-    return true;
-  else if (c1.strengthClass == c2.strengthClass) {
-    for (int i = 0; i < 5; i++) {
-      if (c1.cards.at(i) == c2.cards.at(i)) {
-        continue;
-      }
-      return c1.cards.at(i) < c2.cards.at(i);
-    }
-    throw std::runtime_error("Same hands?");
-  } else {
-    return false;
-  }
+  return c1.key < c2.key;
 }
 
-bool rankCardsTask2(CardBidPair& c1, CardBidPair& c2)
+bool rankCardsTask2(const CardBidPair& c1, const CardBidPair& c2)
 {
-  if (c1.strengthClassTask2 < c2.strengthClassTask2)
-    return true;
-  else if (c1.strengthClassTask2 == c2.strengthClassTask2) {
-    for (int i = 0; i < 5; i++) {
-      auto card1 = c1.cards.at(i);
-      if (card1 == 9)
-        card1 = -1;
-      auto card2 = c2.cards.at(i);
-      if (card2 == 9)
-        card2 = -1;
-      if (card1 == card2) {
-        continue;
-      }
-      return card1 < card2;
+  return c1.keyTask2 < c2.keyTask2;
+}
+
+struct KeyedBid
+{
+  uint32_t key;
+  int64_t bid;
+};
+
+// LSD radix sort by key, one stable counting pass per byte. A pass is skipped if all keys share that byte, so the
+// 23 bit hand keys take three linear passes instead of a comparison sort.
+void radixSortByKey(std::vector<KeyedBid>& entries)
+{
+  std::vector<KeyedBid> scratch(entries.size());
+  for (uint32_t shift = 0; shift < 32; shift += 8) {
+    std::array<std::size_t, 257> offsets{};
+    for (const auto& entry : entries) {
+      offsets[((entry.key >> shift) & 0xFF) + 1]++;
+    }
+    if (r::any_of(offsets, [&entries](std::size_t count) { return count == entries.size(); })) {
+      continue;
     }
-    throw std::runtime_error("Same hands?");
-  } else {
-    return false;
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+    for (const auto& entry : entries) {
+      scratch[offsets[(entry.key >> shift) & 0xFF]++] = entry;
+    }
+    std::swap(entries, scratch);
   }
 }
 
-int64_t task1(const std::vector<CardBidPair> input)
+// Sum of rank times bid, hands ranked by the given key
+int64_t totalWinnings(const std::vector<CardBidPair>& hands, uint32_t CardBidPair::*key)
 {
-  std::vector<CardBidPair> sorted = input;
-  std::sort(sorted.begin(), sorted.end(), rankCards);
+  auto entries = toVector(hands | v::transform([key](const CardBidPair& hand) {
+                            return KeyedBid{.key = hand.*key, .bid = hand.bid};
+                          }));
+  radixSortByKey(entries);
 
   int64_t result{};
-  for (std::size_t i = 0; i < sorted.size(); i++) {
-    result += static_cast<int64_t>(i + 1) * sorted[i].bid;
+  for (std::size_t i = 0; i < entries.size(); i++) {
+    result += static_cast<int64_t>(i + 1) * entries[i].bid;
   }
   return result;
 }
 
-int64_t task2(const std::vector<CardBidPair> input)
+int64_t task1(const std::vector<CardBidPair>& input)
 {
-  std::vector<CardBidPair> sorted = input;
-  std::sort(sorted.begin(), sorted.end(), rankCardsTask2);
+  return totalWinnings(input, &CardBidPair::key);
+}
 
-  int64_t result{};
-  for (std::size_t i = 0; i < sorted.size(); i++) {
-    result += static_cast<int64_t>(i + 1) * sorted[i].bid;
+int64_t task2(const std::vector<CardBidPair>& input)
+{
+  return totalWinnings(input, &CardBidPair::keyTask2);
+}
+
+// Entry point of the aoc runner
+Answers solve(const MappedInput& input, TaskSelection tasks)
+{
+  std::vector<CardBidPair> drawings;
+  {
+    AOC_PROFILE_ZONE("parse");
+    drawings = parallelTransform(input.lines(), CardBidPair::fromStr);
   }
-  return result;
+  Answers answers;
+  if (tasks.task1) {
+    AOC_PROFILE_ZONE("task1");
+    answers.task1 = task1(drawings);
+  }
+  if (tasks.task2) {
+    AOC_PROFILE_ZONE("task2");
+    answers.task2 = task2(drawings);
+  }
+  return answers;
 }
+}  // namespace day7
+
+#ifdef AOC_TESTS
+using namespace day7;
 
 TEST_CASE("Task1 and 2 example input")
 {
@@ -166,16 +235,27 @@ TEST_CASE("Task1 and 2 example input")
   auto r = input | v::transform(CardBidPair::fromStr);
   std::vector<CardBidPair> drawings(r.begin(), r.end());
 
-  REQUIRE(drawings[0] ==
-          CardBidPair{
-              .cards = {1, 0, 8, 1, 11}, .cardsRaw = "32T3K", .bid = 765, .strengthClass = 1, .strengthClassTask2 = 1});
-  REQUIRE(drawings[1] ==
-          CardBidPair{
-              .cards = {8, 3, 3, 9, 3}, .cardsRaw = "T55J5", .bid = 684, .strengthClass = 3, .strengthClassTask2 = 5});
-  REQUIRE(
-      drawings[4] ==
-      CardBidPair{
-          .cards = {10, 10, 10, 9, 12}, .cardsRaw = "QQQJA", .bid = 483, .strengthClass = 3, .strengthClassTask2 = 5});
+  REQUIRE(drawings[0] == CardBidPair{.cards = {1, 0, 8, 1, 11},
+                                      .cardsRaw = "32T3K",
+                                      .bid = 765,
+                                      .strengthClass = 1,
+                                      .strengthClassTask2 = 1,
+                                      .key = 0x11081B,
+                                      .keyTask2 = 0x12192C});
+  REQUIRE(drawings[1] == CardBidPair{.cards = {8, 3, 3, 9, 3},
+                                      .cardsRaw = "T55J5",
+                                      .bid = 684,
+                                      .strengthClass = 3,
+                                      .strengthClassTask2 = 5,
+                                      .key = 0x383393,
+                                      .keyTask2 = 0x594404});
+  REQUIRE(drawings[4] == CardBidPair{.cards = {10, 10, 10, 9, 12},
+                                      .cardsRaw = "QQQJA",
+                                      .bid = 483,
+                                      .strengthClass = 3,
+                                      .strengthClassTask2 = 5,
+                                      .key = 0x3AAA9C,
+                                      .keyTask2 = 0x5BBB0D});
   REQUIRE(drawings.size() == 5);
 
   std::vector<CardBidPair> sorted = drawings;
@@ -186,14 +266,51 @@ TEST_CASE("Task1 and 2 example input")
   REQUIRE(task1(drawings) == 6440);
   REQUIRE(task2(drawings) == 5905);
 
+  REQUIRE_THROWS(CardBidPair::fromStr("32T3X 765"));
+  REQUIRE_THROWS(CardBidPair::fromStr("32T3K"));
+
   // clang-format on
 }
 
+TEST_CASE("Radix sort")
+{
+  auto text = generateToString([](std::ostream& out) { generateDay7(out, {.hands = 5000}, 7); });
+  auto drawings = toVector(splitLines(text) | v::transform(CardBidPair::fromStr));
+
+  // Against a comparison sort of the same keys
+  for (auto key : {&CardBidPair::key, &CardBidPair::keyTask2}) {
+    auto sorted = drawings;
+    std::stable_sort(sorted.begin(), sorted.end(),
+                     [key](const CardBidPair& a, const CardBidPair& b) { return a.*key < b.*key; });
+    int64_t expected{};
+    for (std::size_t i = 0; i < sorted.size(); i++) {
+      expected += static_cast<int64_t>(i + 1) * sorted[i].bid;
+    }
+    REQUIRE(totalWinnings(drawings, key) == expected);
+  }
+
+  std::vector<KeyedBid> entries = {{0x300000, 1}, {0x000102, 2}, {0x000201, 3}, {0x000102, 4}, {0x010000, 5}};
+  radixSortByKey(entries);
+  REQUIRE(r::equal(entries | v::transform(&KeyedBid::bid), std::vector<int64_t>{2, 4, 3, 5, 1}));
+}
+
 TEST_CASE("Tasks")
 {
-  auto input = readLines("../../day7/input.txt");
+  MappedInput input("../../day7/input.txt");
   auto r = input | v::transform(CardBidPair::fromStr);
   std::vector<CardBidPair> drawings(r.begin(), r.end());
   fmt::println("Day7 Task1 result: {}\n", task1(drawings));
   fmt::println("Day7 Task2 result: {}\n", task2(drawings));
 }
+
+TEST_CASE("Benchmark", "[.benchmark]")
+{
+  const std::filesystem::path path = benchmarkInputPath("day7");
+  MappedInput input(path);
+  Benchmark bench("day7", input);
+  bench.run("read", [&] { return MappedInput(path); });
+  auto drawings = bench.run("parse", [&] { return toVector(input | v::transform(CardBidPair::fromStr)); });
+  bench.run("task1", [&] { return task1(drawings); });
+  bench.run("task2", [&] { return task2(drawings); });
+}
+#endif  // AOC_TESTS
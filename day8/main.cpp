@@ -1,10 +1,12 @@
 #include "common.hpp"
+#include "profile.hpp"
+#include "solvers.hpp"
 
 #include <algorithm>
-#include <catch2/catch_test_macros.hpp>
 #include <cctype>
 #include <charconv>
 #include <cstdint>
+#include <filesystem>
 #include <fmt/core.h>
 #include <fmt/format.h>
 #include <ios>
@@ -19,19 +21,29 @@
 #include <unordered_map>
 #include <vector>
 
+#ifdef AOC_TESTS
+#include "bench.hpp"
+#include "generators.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+#endif
+
 namespace r = std::ranges;
 namespace v = std::ranges::views;
 
+namespace day8
+{
+
 struct CamelNavigationSystem
 {
   std::string leftRightOps;
 
   std::map<std::array<char, 3>, std::array<std::array<char, 3>, 2>> connections;
 
-  static CamelNavigationSystem fromStr(const std::vector<std::string>& input)
+  static CamelNavigationSystem fromStr(Lines input)
   {
     CamelNavigationSystem navi;
-    navi.leftRightOps = input[0];
+    navi.leftRightOps = std::string(input[0]);
 
     for (auto& line : input | v::drop(2)) {
       std::array<char, 3> node{};
@@ -108,10 +120,33 @@ int64_t task2(const CamelNavigationSystem& navi)
   return stepCountLCM;
 }
 
+// Entry point of the aoc runner
+Answers solve(const MappedInput& input, TaskSelection tasks)
+{
+  auto navi = [&input] {
+    AOC_PROFILE_ZONE("parse");
+    return CamelNavigationSystem::fromStr(input.lines());
+  }();
+  Answers answers;
+  if (tasks.task1) {
+    AOC_PROFILE_ZONE("task1");
+    answers.task1 = task1(navi);
+  }
+  if (tasks.task2) {
+    AOC_PROFILE_ZONE("task2");
+    answers.task2 = task2(navi);
+  }
+  return answers;
+}
+}  // namespace day8
+
+#ifdef AOC_TESTS
+using namespace day8;
+
 TEST_CASE("Task1 and 2 example input")
 {
   // clang-format off
-  std::vector<std::string> input = {
+  std::vector<std::string_view> input = {
     "LLR",
     "",
     "AAA = (BBB, BBB)",
@@ -159,10 +194,33 @@ TEST_CASE("Task1 and 2 example input")
   REQUIRE(task2(navi) == 6);
 }
 
+TEST_CASE("Generated input")
+{
+  auto input = generateToString([](std::ostream& out) {
+    generateDay8(out, {.instructionLength = 1000, .ghosts = 3, .baseLength = 11}, 42);
+  });
+  auto navi = CamelNavigationSystem::fromStr(splitLines(input));
+
+  REQUIRE(task1(navi) == 11 * 43);
+  REQUIRE(task2(navi) == 11 * 43 * 47 * 53);
+}
+
 TEST_CASE("Tasks")
 {
-  auto input = readLines("../../day8/input.txt");
-  auto navi = CamelNavigationSystem::fromStr(input);
+  MappedInput input("../../day8/input.txt");
+  auto navi = CamelNavigationSystem::fromStr(input.lines());
   fmt::println("Day8 Task1 result: {}\n", task1(navi));
   fmt::println("Day7 Task2 result: {}\n", task2(navi));
 }
+
+TEST_CASE("Benchmark", "[.benchmark]")
+{
+  const std::filesystem::path path = benchmarkInputPath("day8");
+  MappedInput input(path);
+  Benchmark bench("day8", input);
+  bench.run("read", [&] { return MappedInput(path); });
+  auto navi = bench.run("parse", [&] { return CamelNavigationSystem::fromStr(input.lines()); });
+  bench.run("task1", [&] { return task1(navi); });
+  bench.run("task2", [&] { return task2(navi); });
+}
+#endif  // AOC_TESTS
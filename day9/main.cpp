@@ -1,100 +1,163 @@
 #include "common.hpp"
+#include "integer_scanner.hpp"
+#include "profile.hpp"
+#include "solvers.hpp"
 
 #include <algorithm>
-#include <catch2/catch_test_macros.hpp>
-#include <charconv>
+#include <array>
+#include <cstddef>
 #include <deque>
+#include <filesystem>
 #include <fmt/core.h>
 #include <fmt/format.h>
+#include <functional>
+#include <memory_resource>
 #include <ranges>
 #include <scn/scan.h>
+#include <span>
 #include <string>
 #include <string_view>
+#include <utility>
 #include <vector>
 
+#ifdef AOC_TESTS
+#include "bench.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+#endif
+
 namespace r = std::ranges;
 namespace v = std::ranges::views;
 
-std::vector<std::vector<int>> parseSequences(const std::vector<std::string>& lines)
+namespace day9
+{
+
+using Sequence = std::pmr::vector<int>;
+using Sequences = std::pmr::vector<Sequence>;
+
+// Difference trees of one sequence fit into this much stack, larger ones continue on the heap
+constexpr std::size_t treeArenaSize = 16 * 1024;
+
+Sequence parseSequence(std::string_view line, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
 {
-  return toVector(lines | v::transform([](const std::string& line) {
-                    return toVector(line | v::split(' ') | v::transform([](auto&& rng) {
-                                      std::string_view v(rng);
-                                      int value = -1;
-                                      std::from_chars(v.begin(), v.end(), value);
-                                      return value;
-                                    }));
-                  }));
+  Sequence sequence(resource);
+  scanIntegers(line, sequence);
+  return sequence;
 }
 
-int64_t task1(std::vector<std::vector<int>> sequences)
+// Rows and outer vector share resource, pass an arena to release the whole parse at once
+Sequences parseSequences(Lines lines, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
 {
-  int64_t result{};
-  for (auto& sequence : sequences) {
-    std::vector<std::vector<int>> tree;
-    tree.reserve(sequence.size());
-    tree.push_back(sequence);
-    fmt::println("Sequence: {}", fmt::join(tree[0], " "));
-
-    for (std::size_t i = 1; i < sequence.size(); i++) {
-      tree.push_back(toVector(tree[i - 1] | v::slide(2) | v::filter([](auto&& rng) { return rng.size() == 2; }) |
-                              v::transform([](auto&& rng) { return rng[1] - rng[0]; })));
-      fmt::println("Sequence: {}", fmt::join(tree[i], " "));
-      if (r::all_of(tree.back(), [](auto& v) { return v == 0; })) {
-        break;
-      }
-    }
-    tree.back().push_back(0);
-    fmt::println("Sequence: {}", fmt::join(tree.back(), " "));
-    // Add one at the end of each sub tree
-    for (auto it = tree.rbegin() + 1; it != tree.rend(); it++) {
-      auto lowerLevel = (it - 1)->back();
-      auto left = it->back();
-      auto right = left + lowerLevel;
-      it->push_back(right);
-      fmt::println("Sequence: {}", fmt::join(*it, " "));
+  return toPmrVector(lines | v::transform([resource](std::string_view line) { return parseSequence(line, resource); }),
+                     resource);
+}
+
+int64_t extrapolateForward(std::span<const int> sequence)
+{
+  std::array<std::byte, treeArenaSize> buffer;
+  std::pmr::monotonic_buffer_resource arena(buffer.data(), buffer.size());
+  std::pmr::vector<std::pmr::vector<int>> tree(&arena);
+  tree.reserve(sequence.size());
+  tree.emplace_back(sequence.begin(), sequence.end());
+
+  for (std::size_t i = 1; i < sequence.size(); i++) {
+    tree.push_back(toPmrVector(tree[i - 1] | v::slide(2) | v::filter([](auto&& rng) { return rng.size() == 2; }) |
+                                   v::transform([](auto&& rng) { return rng[1] - rng[0]; }),
+                               &arena));
+    if (r::all_of(tree.back(), [](auto& v) { return v == 0; })) {
+      break;
     }
-    result += tree[0].back();
   }
-  return result;
+  tree.back().push_back(0);
+  // Add one at the end of each sub tree
+  for (auto it = tree.rbegin() + 1; it != tree.rend(); it++) {
+    auto lowerLevel = (it - 1)->back();
+    auto left = it->back();
+    auto right = left + lowerLevel;
+    it->push_back(right);
+  }
+  return tree[0].back();
 }
 
-int64_t task2(std::vector<std::vector<int>> sequences)
+int64_t extrapolateBackward(std::span<const int> sequence)
 {
-  int64_t result{};
-  for (auto& sequence : sequences) {
-    std::vector<std::deque<int>> tree;
-    tree.reserve(sequence.size());
-    tree.emplace_back(sequence.begin(), sequence.end());
-    fmt::println("Sequence: {}", fmt::join(tree[0], " "));
-
-    for (std::size_t i = 1; i < sequence.size(); i++) {
-      tree.push_back(toDeque(tree[i - 1] | v::slide(2) | v::filter([](auto&& rng) { return rng.size() == 2; }) |
-                              v::transform([](auto&& rng) { return rng[1] - rng[0]; })));
-      fmt::println("Sequence: {}", fmt::join(tree[i], " "));
-      if (r::all_of(tree.back(), [](auto& v) { return v == 0; })) {
-        break;
-      }
-    }
-    tree.back().push_front(0);
-    fmt::println("Sequence: {}", fmt::join(tree.back(), " "));
-    // Add one at the end of each sub tree
-    for (auto it = tree.rbegin() + 1; it != tree.rend(); it++) {
-      auto lowerLevel = (it - 1)->front();
-      auto right = it->front();
-      auto left = right - lowerLevel;
-      it->push_front(left);
-      fmt::println("Sequence: {}", fmt::join(*it, " "));
+  std::array<std::byte, treeArenaSize> buffer;
+  std::pmr::monotonic_buffer_resource arena(buffer.data(), buffer.size());
+  std::pmr::vector<std::pmr::deque<int>> tree(&arena);
+  tree.reserve(sequence.size());
+  tree.emplace_back(sequence.begin(), sequence.end());
+
+  for (std::size_t i = 1; i < sequence.size(); i++) {
+    tree.push_back(toPmrDeque(tree[i - 1] | v::slide(2) | v::filter([](auto&& rng) { return rng.size() == 2; }) |
+                                  v::transform([](auto&& rng) { return rng[1] - rng[0]; }),
+                              &arena));
+    if (r::all_of(tree.back(), [](auto& v) { return v == 0; })) {
+      break;
     }
-    result += tree[0].front();
   }
+  tree.back().push_front(0);
+  // Add one at the front of each sub tree
+  for (auto it = tree.rbegin() + 1; it != tree.rend(); it++) {
+    auto lowerLevel = (it - 1)->front();
+    auto right = it->front();
+    auto left = right - lowerLevel;
+    it->push_front(left);
+  }
+  return tree[0].front();
+}
+
+int64_t task1(const Sequences& sequences)
+{
+  return parallelTransformReduce(sequences, int64_t{0}, std::plus<>{},
+                                 [](const Sequence& sequence) { return extrapolateForward(sequence); });
+}
+
+int64_t task2(const Sequences& sequences)
+{
+  return parallelTransformReduce(sequences, int64_t{0}, std::plus<>{},
+                                 [](const Sequence& sequence) { return extrapolateBackward(sequence); });
+}
+
+// Single pass over the input with constant memory
+std::pair<int64_t, int64_t> solveStreaming(const std::filesystem::path& path)
+{
+  std::pair<int64_t, int64_t> result{};
+  forEachLine(path, [&result](std::string_view line) {
+    auto sequence = parseSequence(line);
+    result.first += extrapolateForward(sequence);
+    result.second += extrapolateBackward(sequence);
+  });
   return result;
 }
 
+// Entry point of the aoc runner
+Answers solve(const MappedInput& input, TaskSelection tasks)
+{
+  std::pmr::monotonic_buffer_resource arena;
+  auto sequences = [&input, &arena] {
+    AOC_PROFILE_ZONE("parse");
+    return parseSequences(input.lines(), &arena);
+  }();
+  Answers answers;
+  if (tasks.task1) {
+    AOC_PROFILE_ZONE("task1");
+    answers.task1 = task1(sequences);
+  }
+  if (tasks.task2) {
+    AOC_PROFILE_ZONE("task2");
+    answers.task2 = task2(sequences);
+  }
+  return answers;
+}
+}  // namespace day9
+
+#ifdef AOC_TESTS
+using namespace day9;
+
 TEST_CASE("Task1 and 2 example input")
 {
   // clang-format off
-  std::vector<std::string> input = {
+  std::vector<std::string_view> input = {
     "0 3 6 9 12 15",
     "1 3 6 10 15 21",
     "10 13 16 21 30 45",
@@ -103,9 +166,9 @@ TEST_CASE("Task1 and 2 example input")
   auto sequences = parseSequences(input);
 
   REQUIRE(sequences.size() == 3);
-  REQUIRE(sequences[0] == std::vector{0, 3, 6, 9, 12, 15});
-  REQUIRE(sequences[1] == std::vector{1, 3, 6, 10, 15, 21});
-  REQUIRE(sequences[2] == std::vector{10, 13, 16, 21, 30, 45});
+  REQUIRE(sequences[0] == Sequence{0, 3, 6, 9, 12, 15});
+  REQUIRE(sequences[1] == Sequence{1, 3, 6, 10, 15, 21});
+  REQUIRE(sequences[2] == Sequence{10, 13, 16, 21, 30, 45});
 
   REQUIRE(task1({sequences[0]}) == 18);
   REQUIRE(task1(sequences) == 114);
@@ -121,8 +184,24 @@ TEST_CASE("Task1 and 2 example input")
 
 TEST_CASE("Tasks")
 {
-  auto input = readLines("../../day9/input.txt");
-  auto sequences = parseSequences(input);
-  fmt::println("Day9 Task1 result: {}\n", task1(sequences));
-  fmt::println("Day9 Task2 result: {}\n", task2(sequences));
+  auto [task1, task2] = solveStreaming("../../day9/input.txt");
+  fmt::println("Day9 Task1 result: {}\n", task1);
+  fmt::println("Day9 Task2 result: {}\n", task2);
+}
+
+TEST_CASE("Benchmark", "[.benchmark]")
+{
+  const std::filesystem::path path = benchmarkInputPath("day9");
+  MappedInput input(path);
+  Benchmark bench("day9", input);
+  bench.run("read", [&] { return MappedInput(path); });
+  auto sequences = bench.run("parse", [&] { return parseSequences(input.lines()); });
+  bench.run("parse arena", [&] {
+    std::pmr::monotonic_buffer_resource arena;
+    return parseSequences(input.lines(), &arena).size();
+  });
+  bench.run("task1", [&] { return task1(sequences); });
+  bench.run("task2", [&] { return task2(sequences); });
+  bench.run("stream", [&] { return solveStreaming(path); });
 }
+#endif  // AOC_TESTS
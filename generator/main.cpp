@@ -0,0 +1,63 @@
+#include "generators.hpp"
+
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <fmt/core.h>
+#include <fstream>
+#include <string>
+#include <string_view>
+
+namespace
+{
+void printUsage()
+{
+  fmt::println("Usage: aoc_gen <dayN|all> <output file, or directory for all> [scale=1] [seed=1]");
+  fmt::println("Scale 1 is roughly the size of a real puzzle input, it multiplies the main size knob of a day.");
+}
+
+void writeInput(const InputGenerator& generator, const std::filesystem::path& path, std::size_t scale, uint64_t seed)
+{
+  std::ofstream file(path, std::ios::binary);
+  if (!file.is_open()) {
+    throw std::runtime_error("Could not open output file: " + path.string());
+  }
+  generator.generate(file, scale, seed);
+  fmt::println("{}: wrote {} bytes to {}", generator.day, static_cast<std::size_t>(file.tellp()), path.string());
+}
+}  // namespace
+
+int main(int argc, char** argv)
+{
+  if (argc < 3) {
+    printUsage();
+    return 1;
+  }
+
+  try {
+    std::string_view day = argv[1];
+    std::filesystem::path output = argv[2];
+    std::size_t scale = argc > 3 ? std::stoull(argv[3]) : 1;
+    uint64_t seed = argc > 4 ? std::stoull(argv[4]) : 1;
+
+    if (day == "all") {
+      std::filesystem::create_directories(output);
+      for (const auto& generator : inputGenerators) {
+        writeInput(generator, output / (std::string(generator.day) + ".txt"), scale, seed);
+      }
+      return 0;
+    }
+
+    for (const auto& generator : inputGenerators) {
+      if (generator.day == day) {
+        writeInput(generator, output, scale, seed);
+        return 0;
+      }
+    }
+    fmt::println("Unknown day: {}", day);
+    printUsage();
+  } catch (const std::exception& e) {
+    fmt::println("Error: {}", e.what());
+  }
+  return 1;
+}
@@ -0,0 +1,206 @@
+#pragma once
+
+#include "mapped_input.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <filesystem>
+#include <fmt/core.h>
+#include <fmt/format.h>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Benchmarks read $AOC_INPUT_DIR/<day>.txt if the variable is set (e.g. inputs written by aoc_gen), otherwise
+// the real puzzle input
+inline std::filesystem::path benchmarkInputPath(std::string_view day)
+{
+#ifdef _MSC_VER
+#pragma warning(suppress : 4996)
+#endif
+  const char* inputDir = std::getenv("AOC_INPUT_DIR");
+  if (inputDir != nullptr) {
+    return std::filesystem::path(inputDir) / (std::string(day) + ".txt");
+  }
+  return std::filesystem::path("../..") / day / "input.txt";
+}
+
+// Keeps the compiler from optimizing away a benchmarked result
+template<class T>
+inline void doNotOptimize(const T& value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+  asm volatile("" : : "r,m"(value) : "memory");
+#else
+  static volatile const void* sink;
+  sink = &value;
+#endif
+}
+
+struct BenchmarkConfig
+{
+  std::size_t warmupIterations{3};
+  std::size_t samples{15};
+  // Fast functions are repeated until a sample takes at least this long
+  std::chrono::nanoseconds minSampleTime{std::chrono::milliseconds(1)};
+};
+
+struct BenchmarkResult
+{
+  std::string name;
+  std::size_t warmupIterations{};
+  std::size_t samples{};
+  std::size_t iterationsPerSample{};
+  double medianNs{};
+  double madNs{};
+  std::size_t bytes{};
+  std::size_t lines{};
+};
+
+inline double median(std::vector<double> values)
+{
+  if (values.empty()) {
+    return 0.0;
+  }
+  auto mid = values.begin() + static_cast<std::ptrdiff_t>(values.size() / 2);
+  std::nth_element(values.begin(), mid, values.end());
+  if (values.size() % 2 == 1) {
+    return *mid;
+  }
+  return (*mid + *std::max_element(values.begin(), mid)) / 2.0;
+}
+
+inline std::string formatDuration(double ns)
+{
+  if (ns >= 1e9) {
+    return fmt::format("{:.3f} s", ns / 1e9);
+  }
+  if (ns >= 1e6) {
+    return fmt::format("{:.3f} ms", ns / 1e6);
+  }
+  if (ns >= 1e3) {
+    return fmt::format("{:.3f} us", ns / 1e3);
+  }
+  return fmt::format("{:.1f} ns", ns);
+}
+
+inline std::string formatRate(double perSecond, std::string_view unit)
+{
+  if (perSecond >= 1e9) {
+    return fmt::format("{:.2f} G{}/s", perSecond / 1e9, unit);
+  }
+  if (perSecond >= 1e6) {
+    return fmt::format("{:.2f} M{}/s", perSecond / 1e6, unit);
+  }
+  if (perSecond >= 1e3) {
+    return fmt::format("{:.2f} k{}/s", perSecond / 1e3, unit);
+  }
+  return fmt::format("{:.2f} {}/s", perSecond, unit);
+}
+
+// Times the phases (read, parse, task1, ...) of a day one after another. Every phase is warmed up, then
+// sampled; median and median absolute deviation are reported together with the throughput relative to
+// the size of the day's input.
+class Benchmark
+{
+public:
+  Benchmark(std::string suite, const MappedInput& input, BenchmarkConfig config = {})
+      : suite_(std::move(suite)), bytes_(input.data().size()), lines_(input.size()), config_(config)
+  {
+  }
+
+  Benchmark(std::string suite, std::size_t bytes, std::size_t lines, BenchmarkConfig config = {})
+      : suite_(std::move(suite)), bytes_(bytes), lines_(lines), config_(config)
+  {
+  }
+
+  // Runs fn repeatedly and returns the result of one more, untimed invocation, so it can feed the next phase
+  template<class Fn>
+  std::invoke_result_t<Fn> run(std::string_view name, Fn&& fn)
+  {
+    using Clock = std::chrono::steady_clock;
+    using Result = std::invoke_result_t<Fn>;
+
+    auto call = [&fn] {
+      if constexpr (std::is_void_v<Result>) {
+        fn();
+      } else {
+        doNotOptimize(fn());
+      }
+    };
+
+    auto warmupStart = Clock::now();
+    for (std::size_t i = 0; i < config_.warmupIterations; i++) {
+      call();
+    }
+    auto warmupTime = Clock::now() - warmupStart;
+
+    std::size_t iterations = 1;
+    if (config_.warmupIterations > 0) {
+      auto perIteration = warmupTime / config_.warmupIterations;
+      if (perIteration.count() > 0 && perIteration < config_.minSampleTime) {
+        iterations = static_cast<std::size_t>(config_.minSampleTime / perIteration);
+      } else if (perIteration.count() == 0) {
+        iterations = 1000;
+      }
+    }
+
+    std::vector<double> samples;
+    samples.reserve(config_.samples);
+    for (std::size_t s = 0; s < std::max<std::size_t>(config_.samples, 1); s++) {
+      auto start = Clock::now();
+      for (std::size_t i = 0; i < iterations; i++) {
+        call();
+      }
+      std::chrono::duration<double, std::nano> elapsed = Clock::now() - start;
+      samples.push_back(elapsed.count() / static_cast<double>(iterations));
+    }
+
+    BenchmarkResult benchmark{
+        .name = std::string(name),
+        .warmupIterations = config_.warmupIterations,
+        .samples = samples.size(),
+        .iterationsPerSample = iterations,
+        .medianNs = median(samples),
+        .madNs = 0.0,
+        .bytes = bytes_,
+        .lines = lines_,
+    };
+    for (auto& sample : samples) {
+      sample = std::abs(sample - benchmark.medianNs);
+    }
+    benchmark.madNs = median(std::move(samples));
+
+    report(benchmark);
+    results_.push_back(std::move(benchmark));
+
+    return fn();
+  }
+
+  const std::vector<BenchmarkResult>& results() const
+  {
+    return results_;
+  }
+
+private:
+  void report(const BenchmarkResult& result) const
+  {
+    double seconds = result.medianNs / 1e9;
+    double lineRate = seconds > 0 ? static_cast<double>(result.lines) / seconds : 0.0;
+    double byteRate = seconds > 0 ? static_cast<double>(result.bytes) / seconds : 0.0;
+    fmt::println("{:<8} {:<10} warmup {:>2} x{:<6} median {:>12} MAD {:>12} {:>16} {:>14}", suite_, result.name,
+                 result.warmupIterations, result.iterationsPerSample, formatDuration(result.medianNs),
+                 formatDuration(result.madNs), formatRate(lineRate, "lines"), formatRate(byteRate, "B"));
+  }
+
+  std::string suite_;
+  std::size_t bytes_{};
+  std::size_t lines_{};
+  BenchmarkConfig config_;
+  std::vector<BenchmarkResult> results_;
+};
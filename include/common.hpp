@@ -1,12 +1,28 @@
 #pragma once
 
+#include "mapped_input.hpp"
+#include "work_stealing_pool.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
 #include <deque>
 #include <filesystem>
 #include <fstream>
+#include <memory_resource>
+#include <optional>
 #include <ranges>
+#include <span>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
+// Lines of an input, usually pointing into a MappedInput
+using Lines = std::span<const std::string_view>;
+
 inline std::vector<std::string> readLines(const std::filesystem::path& path)
 {
   std::ifstream file(path);
@@ -39,9 +55,232 @@ inline auto toDeque(auto&& rng)
   return std::deque(rng.begin(), rng.end());
 }
 
-inline std::vector<std::vector<std::string>> splitOnEmptyRows(const std::vector<std::string>& lines)
+// Arena variants of toVector/toDeque. Backed by a std::pmr::monotonic_buffer_resource, all allocations of a parse
+// (including nested containers built with the same resource) are released in one go when the arena is destroyed.
+inline auto toPmrVector(auto&& rng, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+{
+  std::pmr::vector<std::ranges::range_value_t<decltype(rng)>> result(resource);
+  if constexpr (std::ranges::sized_range<decltype(rng)>) {
+    result.reserve(std::ranges::size(rng));
+  }
+  for (auto&& element : rng) {
+    result.emplace_back(std::forward<decltype(element)>(element));
+  }
+  return result;
+}
+
+inline auto toPmrDeque(auto&& rng, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+{
+  std::pmr::deque<std::ranges::range_value_t<decltype(rng)>> result(resource);
+  for (auto&& element : rng) {
+    result.emplace_back(std::forward<decltype(element)>(element));
+  }
+  return result;
+}
+
+// Zero-copy, the blocks are sub-spans of lines
+inline std::vector<Lines> splitOnEmptyRows(Lines lines)
 {
   namespace v = std::ranges::views;
-  return toVector(lines | v::split("") | v::transform([](const auto& r) { return std::vector<std::string>(r.begin(), r.end()); }));
+  return toVector(lines | v::split(std::string_view{}) |
+                  v::transform([](const auto& r) { return Lines(r.begin(), r.end()); }));
+}
+
+// Cuts text into pieces of about pieceSize bytes that all end right behind a newline (the last one at the end of
+// text), so whole buffer kernels can work on the pieces in parallel without ever splitting a line
+inline std::vector<std::string_view> splitIntoLineChunks(std::string_view text, std::size_t pieceSize)
+{
+  std::vector<std::string_view> pieces;
+  pieceSize = std::max<std::size_t>(pieceSize, 1);
+  while (!text.empty()) {
+    auto newline = pieceSize < text.size() ? text.find('\n', pieceSize - 1) : std::string_view::npos;
+    auto length = newline == std::string_view::npos ? text.size() : newline + 1;
+    pieces.push_back(text.substr(0, length));
+    text.remove_prefix(length);
+  }
+  return pieces;
+}
+
+// Records per chunk of the parallel algorithms below, enough to amortize handing out a chunk while a chunk of lines
+// still fits into L1. Chunk boundaries only depend on the input size, never on the thread count, so the results
+// do not either.
+inline constexpr std::size_t defaultParallelGrain = 256;
+
+// transform_reduce over a random access range (lines, blocks, parsed records) on the shared WorkStealingPool. Each
+// chunk is folded left to right starting with its first element, the chunk results are then folded in chunk order
+// onto init. The reduction order is therefore fixed and reduce only has to be associative, not commutative.
+template<std::ranges::random_access_range R, class T, class Reduce, class Transform>
+T parallelTransformReduce(R&& range, T init, Reduce reduce, Transform transform,
+                          std::size_t grain = defaultParallelGrain)
+{
+  auto first = std::ranges::begin(range);
+  const auto count = static_cast<std::size_t>(std::ranges::size(range));
+  grain = std::max<std::size_t>(grain, 1);
+  std::vector<std::optional<T>> partials((count + grain - 1) / grain);
+  WorkStealingPool::global().forEachChunk(count, grain, [&](std::size_t begin, std::size_t end) {
+    auto element = first + static_cast<std::ranges::range_difference_t<R>>(begin);
+    T partial = transform(*element);
+    for (auto i = begin + 1; i < end; i++) {
+      partial = reduce(std::move(partial), transform(*++element));
+    }
+    partials[begin / grain] = std::move(partial);
+  });
+  for (auto& partial : partials) {
+    init = reduce(std::move(init), std::move(*partial));
+  }
+  return init;
+}
+
+// Parallel std::transform of a random access range into a vector, the result type has to be default constructible
+template<std::ranges::random_access_range R, class Transform>
+auto parallelTransform(R&& range, Transform transform, std::size_t grain = defaultParallelGrain)
+{
+  auto first = std::ranges::begin(range);
+  const auto count = static_cast<std::size_t>(std::ranges::size(range));
+  std::vector<std::decay_t<std::invoke_result_t<Transform&, std::ranges::range_reference_t<R>>>> result(count);
+  WorkStealingPool::global().forEachChunk(count, grain, [&](std::size_t begin, std::size_t end) {
+    std::transform(first + static_cast<std::ranges::range_difference_t<R>>(begin),
+                   first + static_cast<std::ranges::range_difference_t<R>>(end),
+                   result.begin() + static_cast<std::ptrdiff_t>(begin), transform);
+  });
+  return result;
+}
+
+// Reads a file line by line through a fixed size buffer, so arbitrarily large inputs can be processed with
+// constant memory. The buffer only grows if a single line does not fit into it.
+class LineStream
+{
+public:
+  static constexpr std::size_t defaultBufferSize = 64 * 1024;
+
+  explicit LineStream(const std::filesystem::path& path, std::size_t bufferSize = defaultBufferSize)
+      : file_(path, std::ios::binary), buffer_(std::max<std::size_t>(bufferSize, 1))
+  {
+    if (!file_.is_open()) {
+      throw std::runtime_error("Could not open input file: " + path.string());
+    }
+  }
+
+  // Returns false at the end of the input. The line is only valid until the next call.
+  bool next(std::string_view& line)
+  {
+    while (true) {
+      const char* begin = buffer_.data() + begin_;
+      const char* newline = static_cast<const char*>(std::memchr(begin + scanned_, '\n', end_ - begin_ - scanned_));
+      if (newline != nullptr) {
+        line = std::string_view(begin, static_cast<std::size_t>(newline - begin));
+        begin_ += line.size() + 1;
+        scanned_ = 0;
+        return true;
+      }
+
+      if (eof_) {
+        if (begin_ == end_) {
+          return false;
+        }
+        // Last line without trailing newline
+        line = std::string_view(begin, end_ - begin_);
+        begin_ = end_;
+        scanned_ = 0;
+        return true;
+      }
+
+      refill();
+    }
+  }
+
+private:
+  void refill()
+  {
+    // Keep the partial line and move it to the front
+    std::size_t remaining = end_ - begin_;
+    scanned_ = remaining;
+    std::memmove(buffer_.data(), buffer_.data() + begin_, remaining);
+    begin_ = 0;
+    end_ = remaining;
+    if (end_ == buffer_.size()) {
+      buffer_.resize(buffer_.size() * 2);
+    }
+
+    file_.read(buffer_.data() + end_, static_cast<std::streamsize>(buffer_.size() - end_));
+    auto readCount = static_cast<std::size_t>(file_.gcount());
+    end_ += readCount;
+    if (readCount == 0 || !file_) {
+      eof_ = true;
+    }
+  }
+
+  std::ifstream file_;
+  std::vector<char> buffer_;
+  std::size_t begin_{};
+  std::size_t end_{};
+  std::size_t scanned_{};
+  bool eof_{false};
+};
+
+// Groups the lines of a LineStream into blocks separated by empty lines, the streaming counterpart of
+// splitOnEmptyRows. Empty blocks are skipped. Only the current block is kept in memory.
+class BlockStream
+{
+public:
+  explicit BlockStream(const std::filesystem::path& path, std::size_t bufferSize = LineStream::defaultBufferSize)
+      : lines_(path, bufferSize)
+  {
+  }
+
+  // Returns false at the end of the input. The block is only valid until the next call.
+  bool next(Lines& block)
+  {
+    storage_.clear();
+    lineEnds_.clear();
+
+    std::string_view line;
+    while (lines_.next(line)) {
+      if (line.empty()) {
+        if (lineEnds_.empty()) {
+          continue;
+        }
+        break;
+      }
+      storage_.append(line);
+      lineEnds_.push_back(storage_.size());
+    }
+
+    // Views can only be created once the storage does not reallocate anymore
+    blockLines_.clear();
+    std::size_t lineBegin = 0;
+    for (auto lineEnd : lineEnds_) {
+      blockLines_.emplace_back(storage_.data() + lineBegin, lineEnd - lineBegin);
+      lineBegin = lineEnd;
+    }
+    block = blockLines_;
+
+    return !blockLines_.empty();
+  }
+
+private:
+  LineStream lines_;
+  std::string storage_;
+  std::vector<std::size_t> lineEnds_;
+  std::vector<std::string_view> blockLines_;
+};
+
+inline void forEachLine(const std::filesystem::path& path, auto&& fn,
+                        std::size_t bufferSize = LineStream::defaultBufferSize)
+{
+  LineStream stream(path, bufferSize);
+  std::string_view line;
+  while (stream.next(line)) {
+    fn(line);
+  }
 }
 
+inline void forEachBlock(const std::filesystem::path& path, auto&& fn,
+                         std::size_t bufferSize = LineStream::defaultBufferSize)
+{
+  BlockStream stream(path, bufferSize);
+  Lines block;
+  while (stream.next(block)) {
+    fn(block);
+  }
+}
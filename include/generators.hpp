@@ -0,0 +1,805 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <ostream>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Seeded, deterministic generators for synthetic puzzle inputs of arbitrary size. Every generator writes
+// an input in the same format as the real puzzle input to a stream, so it can go to a file (aoc_gen) or
+// into memory for tests and benchmarks. The same seed and parameters always produce the same bytes, on
+// every platform (no std:: distributions are used).
+
+// splitmix64, small and fast with a fully specified output sequence
+class SeededRng
+{
+public:
+  explicit SeededRng(uint64_t seed) : state_(seed) {}
+
+  uint64_t next()
+  {
+    uint64_t z = (state_ += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+  }
+
+  // Uniform in [lo, hi]
+  int64_t uniform(int64_t lo, int64_t hi)
+  {
+    uint64_t span = static_cast<uint64_t>(hi - lo) + 1;
+    if (span == 0) {
+      return static_cast<int64_t>(next());
+    }
+    return lo + static_cast<int64_t>(next() % span);
+  }
+
+  std::size_t index(std::size_t size)
+  {
+    return static_cast<std::size_t>(uniform(0, static_cast<int64_t>(size) - 1));
+  }
+
+  bool chance(double probability)
+  {
+    return static_cast<double>(next() >> 11) * 0x1.0p-53 < probability;
+  }
+
+  template<class T>
+  void shuffle(std::vector<T>& values)
+  {
+    for (std::size_t i = values.size(); i > 1; i--) {
+      std::swap(values[i - 1], values[index(i)]);
+    }
+  }
+
+private:
+  uint64_t state_;
+};
+
+inline std::string generateToString(auto&& generator)
+{
+  std::ostringstream out;
+  generator(out);
+  return std::move(out).str();
+}
+
+struct Day1Params
+{
+  std::size_t lines{1000};
+  std::size_t minLength{4};
+  std::size_t maxLength{40};
+  double digitRatio{0.05};
+  double writtenDigitRatio{0.05};
+};
+
+inline void generateDay1(std::ostream& out, const Day1Params& params, uint64_t seed = 1)
+{
+  static constexpr std::array<std::string_view, 10> writtenDigits = {"zero", "one", "two",   "three", "four",
+                                                                     "five", "six", "seven", "eight", "nine"};
+  SeededRng rng(seed);
+  std::string line;
+  for (std::size_t i = 0; i < params.lines; i++) {
+    line.clear();
+    auto length = static_cast<std::size_t>(
+        rng.uniform(static_cast<int64_t>(params.minLength), static_cast<int64_t>(params.maxLength)));
+    bool hasDigit = false;
+    while (line.size() < length) {
+      if (rng.chance(params.digitRatio)) {
+        line += static_cast<char>('1' + rng.index(9));
+        hasDigit = true;
+      } else if (rng.chance(params.writtenDigitRatio)) {
+        line += writtenDigits[1 + rng.index(9)];
+      } else {
+        line += static_cast<char>('a' + rng.index(26));
+      }
+    }
+    // Task1 needs at least one real digit per line
+    if (!hasDigit) {
+      line.insert(line.begin() + static_cast<std::ptrdiff_t>(rng.index(line.size() + 1)),
+                  static_cast<char>('1' + rng.index(9)));
+    }
+    line += '\n';
+    out.write(line.data(), static_cast<std::streamsize>(line.size()));
+  }
+}
+
+struct Day2Params
+{
+  std::size_t games{100};
+  std::size_t maxDrawings{6};
+  int maxCubes{20};
+};
+
+inline void generateDay2(std::ostream& out, const Day2Params& params, uint64_t seed = 1)
+{
+  static constexpr std::array<std::string_view, 3> colors = {"red", "green", "blue"};
+  SeededRng rng(seed);
+  std::string line;
+  for (std::size_t game = 1; game <= params.games; game++) {
+    line = "Game " + std::to_string(game) + ":";
+    auto drawings = rng.uniform(1, static_cast<int64_t>(params.maxDrawings));
+    for (int64_t d = 0; d < drawings; d++) {
+      std::array<std::size_t, 3> order = {0, 1, 2};
+      for (std::size_t i = 3; i > 1; i--) {
+        std::swap(order[i - 1], order[rng.index(i)]);
+      }
+      auto colorCount = rng.uniform(1, 3);
+      for (int64_t c = 0; c < colorCount; c++) {
+        line += ' ';
+        line += std::to_string(rng.uniform(1, params.maxCubes));
+        line += ' ';
+        line += colors[order[static_cast<std::size_t>(c)]];
+        if (c + 1 < colorCount) {
+          line += ',';
+        }
+      }
+      if (d + 1 < drawings) {
+        line += ';';
+      }
+    }
+    line += '\n';
+    out.write(line.data(), static_cast<std::streamsize>(line.size()));
+  }
+}
+
+struct Day3Params
+{
+  std::size_t width{140};
+  std::size_t height{140};
+  double numberDensity{0.08};
+  double symbolDensity{0.03};
+  double gearRatio{0.3};
+};
+
+inline void generateDay3(std::ostream& out, const Day3Params& params, uint64_t seed = 1)
+{
+  static constexpr std::string_view symbols = "#+$/=%@&-";
+  SeededRng rng(seed);
+  std::string row;
+  for (std::size_t y = 0; y < params.height; y++) {
+    row.assign(params.width, '.');
+    for (std::size_t x = 0; x < params.width; x++) {
+      if (rng.chance(params.numberDensity)) {
+        auto digits = std::min<std::size_t>(static_cast<std::size_t>(rng.uniform(1, 3)), params.width - x);
+        row[x] = static_cast<char>('1' + rng.index(9));
+        for (std::size_t i = 1; i < digits; i++) {
+          row[x + i] = static_cast<char>('0' + rng.index(10));
+        }
+        // Keep a non digit after every number so numbers do not merge
+        x += digits;
+      } else if (rng.chance(params.symbolDensity)) {
+        row[x] = rng.chance(params.gearRatio) ? '*' : symbols[rng.index(symbols.size())];
+      }
+    }
+    row += '\n';
+    out.write(row.data(), static_cast<std::streamsize>(row.size()));
+  }
+}
+
+struct Day4Params
+{
+  std::size_t cards{200};
+  std::size_t winningCount{10};
+  std::size_t presentCount{25};
+  int maxNumber{99};
+};
+
+inline void generateDay4(std::ostream& out, const Day4Params& params, uint64_t seed = 1)
+{
+  if (static_cast<std::size_t>(params.maxNumber) < params.winningCount + params.presentCount) {
+    throw std::invalid_argument("maxNumber too small for the requested card size");
+  }
+  SeededRng rng(seed);
+  std::vector<int> numbers(static_cast<std::size_t>(params.maxNumber));
+  std::iota(numbers.begin(), numbers.end(), 1);
+  auto width = std::to_string(params.maxNumber).size();
+  auto appendNumber = [width](std::string& line, int number) {
+    auto str = std::to_string(number);
+    line += ' ';
+    line.append(width - str.size(), ' ');
+    line += str;
+  };
+
+  std::string line;
+  for (std::size_t card = 1; card <= params.cards; card++) {
+    // Like real inputs mostly zero to two matches and rarely more, under one match per card on average keeps the
+    // copy counts bounded instead of growing exponentially with the number of cards
+    auto cardSize = static_cast<int64_t>(std::min(params.winningCount, params.presentCount));
+    auto roll = rng.uniform(0, 99);
+    auto drawn = roll < 60 ? 0 : roll < 82 ? 1 : roll < 96 ? 2 : rng.uniform(0, cardSize);
+    // Cards never win copies of cards past the end of the table
+    auto matches = std::min({static_cast<std::size_t>(drawn), static_cast<std::size_t>(cardSize), params.cards - card});
+
+    // First winningCount numbers are winning, the matching ones are reused for present
+    rng.shuffle(numbers);
+    std::vector<int> present(numbers.begin(), numbers.begin() + static_cast<std::ptrdiff_t>(matches));
+    present.insert(present.end(), numbers.begin() + static_cast<std::ptrdiff_t>(params.winningCount),
+                   numbers.begin() + static_cast<std::ptrdiff_t>(params.winningCount + params.presentCount - matches));
+    rng.shuffle(present);
+
+    line = "Card " + std::to_string(card) + ":";
+    for (std::size_t i = 0; i < params.winningCount; i++) {
+      appendNumber(line, numbers[i]);
+    }
+    line += " |";
+    for (auto p : present) {
+      appendNumber(line, p);
+    }
+    line += '\n';
+    out.write(line.data(), static_cast<std::streamsize>(line.size()));
+  }
+}
+
+struct Day5Params
+{
+  std::size_t seedRanges{10};
+  std::size_t mappingsPerStage{40};
+  int64_t valueRange{int64_t{1} << 32};
+  // Probability that a segment of the value range is left unmapped (identity)
+  double identityRatio{0.1};
+};
+
+inline void generateDay5(std::ostream& out, const Day5Params& params, uint64_t seed = 1)
+{
+  static constexpr std::array<std::string_view, 7> stages = {
+      "seed-to-soil",         "soil-to-fertilizer",      "fertilizer-to-water", "water-to-light",
+      "light-to-temperature", "temperature-to-humidity", "humidity-to-location"};
+  if (static_cast<int64_t>(params.mappingsPerStage) >= params.valueRange) {
+    throw std::invalid_argument("valueRange too small for the requested number of mappings");
+  }
+  SeededRng rng(seed);
+
+  std::string line = "seeds:";
+  auto maxSeedLength = std::max<int64_t>(1, params.valueRange / static_cast<int64_t>(4 * params.seedRanges));
+  for (std::size_t i = 0; i < params.seedRanges; i++) {
+    auto length = rng.uniform(1, maxSeedLength);
+    line += ' ' + std::to_string(rng.uniform(0, params.valueRange - length));
+    line += ' ' + std::to_string(length);
+  }
+  line += '\n';
+  out.write(line.data(), static_cast<std::streamsize>(line.size()));
+
+  std::vector<int64_t> cuts;
+  std::vector<std::size_t> order;
+  for (auto stage : stages) {
+    line = "\n" + std::string(stage) + " map:\n";
+    out.write(line.data(), static_cast<std::streamsize>(line.size()));
+
+    // Partition the value range into segments and map them onto a permutation of themselves, so the
+    // sources never overlap
+    cuts.clear();
+    cuts.push_back(0);
+    cuts.push_back(params.valueRange);
+    while (cuts.size() < params.mappingsPerStage + 1) {
+      for (std::size_t i = cuts.size(); i < params.mappingsPerStage + 1; i++) {
+        cuts.push_back(rng.uniform(1, params.valueRange - 1));
+      }
+      std::sort(cuts.begin(), cuts.end());
+      cuts.erase(std::unique(cuts.begin(), cuts.end()), cuts.end());
+    }
+
+    std::size_t segments = cuts.size() - 1;
+    order.resize(segments);
+    std::iota(order.begin(), order.end(), 0);
+    rng.shuffle(order);
+
+    int64_t dst = 0;
+    std::vector<int64_t> dstStarts(segments);
+    for (auto segment : order) {
+      dstStarts[segment] = dst;
+      dst += cuts[segment + 1] - cuts[segment];
+    }
+
+    rng.shuffle(order);
+    for (auto segment : order) {
+      if (rng.chance(params.identityRatio)) {
+        continue;
+      }
+      line = std::to_string(dstStarts[segment]) + ' ' + std::to_string(cuts[segment]) + ' ' +
+             std::to_string(cuts[segment + 1] - cuts[segment]) + '\n';
+      out.write(line.data(), static_cast<std::streamsize>(line.size()));
+    }
+  }
+}
+
+struct Day6Params
+{
+  std::size_t races{4};
+  int64_t minTime{7};
+  int64_t maxTime{100};
+};
+
+// Note: task2 concatenates all numbers, so only small race counts stay within 64 bit for it
+inline void generateDay6(std::ostream& out, const Day6Params& params, uint64_t seed = 1)
+{
+  SeededRng rng(seed);
+  std::vector<int64_t> times(params.races);
+  std::vector<int64_t> distances(params.races);
+  for (std::size_t i = 0; i < params.races; i++) {
+    times[i] = rng.uniform(std::max<int64_t>(params.minTime, 2), params.maxTime);
+    // Best possible distance is floor(T^2 / 4), the record has to be beatable
+    auto best = (times[i] / 2) * (times[i] - times[i] / 2);
+    distances[i] = rng.uniform(best / 2, best - 1);
+  }
+
+  std::string timeLine = "Time:    ";
+  std::string distanceLine = "Distance:";
+  for (std::size_t i = 0; i < params.races; i++) {
+    auto time = std::to_string(times[i]);
+    auto distance = std::to_string(distances[i]);
+    auto width = std::max(time.size(), distance.size()) + 2;
+    timeLine.append(width - time.size(), ' ') += time;
+    distanceLine.append(width - distance.size(), ' ') += distance;
+  }
+  timeLine += '\n';
+  distanceLine += '\n';
+  out.write(timeLine.data(), static_cast<std::streamsize>(timeLine.size()));
+  out.write(distanceLine.data(), static_cast<std::streamsize>(distanceLine.size()));
+}
+
+struct Day7Params
+{
+  std::size_t hands{1000};
+  int maxBid{1000};
+  // Probability to draw a card that is already in the hand, which makes pairs and full houses likelier
+  double repeatRatio{0.3};
+};
+
+inline void generateDay7(std::ostream& out, const Day7Params& params, uint64_t seed = 1)
+{
+  static constexpr std::string_view cards = "AKQJT98765432";
+  // rankCards requires unique hands
+  if (params.hands > 371293) {
+    throw std::invalid_argument("There are only 13^5 different hands");
+  }
+  SeededRng rng(seed);
+  std::set<std::string> seen;
+  std::string line;
+  while (seen.size() < params.hands) {
+    std::string hand;
+    for (std::size_t i = 0; i < 5; i++) {
+      hand += (i > 0 && rng.chance(params.repeatRatio)) ? hand[rng.index(i)] : cards[rng.index(cards.size())];
+    }
+    if (!seen.insert(hand).second) {
+      continue;
+    }
+    line = hand + ' ' + std::to_string(rng.uniform(1, params.maxBid)) + '\n';
+    out.write(line.data(), static_cast<std::streamsize>(line.size()));
+  }
+}
+
+struct Day8Params
+{
+  std::size_t instructionLength{300};
+  // Number of **A start nodes, the first one is AAA and leads to ZZZ
+  std::size_t ghosts{6};
+  // Path length from each start to its end node is baseLength * (a distinct prime), so the LCM of task2
+  // stays well inside 64 bit
+  std::size_t baseLength{61};
+};
+
+// The left and right successors of every node are identical, so every start walks a fixed chain of
+// nodes and reaches its end node periodically, as in the real puzzle.
+inline void generateDay8(std::ostream& out, const Day8Params& params, uint64_t seed = 1)
+{
+  static constexpr std::string_view alphabet = "BCDEFGHIJKLMNOPQRSTUVWXY0123456789";
+  static constexpr std::array<std::size_t, 12> primes = {43, 47, 53, 59, 61, 67, 71, 73, 79, 83, 89, 97};
+  if (params.ghosts == 0 || params.ghosts > primes.size()) {
+    throw std::invalid_argument("Unsupported ghost count");
+  }
+  std::size_t nodeCount{};
+  for (std::size_t g = 0; g < params.ghosts; g++) {
+    nodeCount += params.baseLength * primes[g];
+  }
+  if (nodeCount > alphabet.size() * alphabet.size() * alphabet.size()) {
+    throw std::invalid_argument("Too many nodes for 3 character labels");
+  }
+
+  SeededRng rng(seed);
+  std::string line;
+  for (std::size_t i = 0; i < params.instructionLength; i++) {
+    line += rng.chance(0.5) ? 'L' : 'R';
+  }
+  line += "\n\n";
+  out.write(line.data(), static_cast<std::streamsize>(line.size()));
+
+  // Intermediate labels never contain 'A' or 'Z', shuffled so the chains are scattered over the label space
+  std::vector<std::size_t> labelIds(alphabet.size() * alphabet.size() * alphabet.size());
+  std::iota(labelIds.begin(), labelIds.end(), 0);
+  rng.shuffle(labelIds);
+  auto label = [](std::size_t id) {
+    auto size = alphabet.size();
+    return std::string{alphabet[id / (size * size)], alphabet[(id / size) % size], alphabet[id % size]};
+  };
+
+  std::size_t nextLabel = 0;
+  std::vector<std::string> lines;
+  for (std::size_t g = 0; g < params.ghosts; g++) {
+    std::string start = g == 0 ? "AAA" : std::string{alphabet[g / alphabet.size()], alphabet[g % alphabet.size()], 'A'};
+    std::string end = g == 0 ? "ZZZ" : std::string{alphabet[g / alphabet.size()], alphabet[g % alphabet.size()], 'Z'};
+
+    // start -> p1 -> ... -> end -> p1, so end is reached every `length` steps
+    std::size_t length = params.baseLength * primes[g];
+    std::vector<std::string> chain = {start};
+    for (std::size_t i = 1; i < length; i++) {
+      chain.push_back(label(labelIds[nextLabel++]));
+    }
+    chain.push_back(end);
+    for (std::size_t i = 0; i + 1 < chain.size(); i++) {
+      lines.push_back(chain[i] + " = (" + chain[i + 1] + ", " + chain[i + 1] + ")\n");
+    }
+    lines.push_back(end + " = (" + chain[1] + ", " + chain[1] + ")\n");
+  }
+
+  rng.shuffle(lines);
+  for (const auto& l : lines) {
+    out.write(l.data(), static_cast<std::streamsize>(l.size()));
+  }
+}
+
+struct Day9Params
+{
+  std::size_t sequences{200};
+  std::size_t length{21};
+  int maxDegree{5};
+  int maxCoefficient{3};
+};
+
+// Sequences are polynomials with small coefficients, so the differences converge to zero
+inline void generateDay9(std::ostream& out, const Day9Params& params, uint64_t seed = 1)
+{
+  SeededRng rng(seed);
+  std::string line;
+  std::vector<int64_t> coefficients;
+  for (std::size_t s = 0; s < params.sequences; s++) {
+    coefficients.resize(static_cast<std::size_t>(rng.uniform(0, params.maxDegree)) + 1);
+    for (auto& c : coefficients) {
+      c = rng.uniform(-params.maxCoefficient, params.maxCoefficient);
+    }
+    auto offset = rng.uniform(-5, 5);
+
+    line.clear();
+    for (std::size_t i = 0; i < params.length; i++) {
+      int64_t x = static_cast<int64_t>(i) + offset;
+      int64_t value = 0;
+      for (auto it = coefficients.rbegin(); it != coefficients.rend(); it++) {
+        value = value * x + *it;
+      }
+      if (i > 0) {
+        line += ' ';
+      }
+      line += std::to_string(value);
+    }
+    line += '\n';
+    out.write(line.data(), static_cast<std::streamsize>(line.size()));
+  }
+}
+
+struct Day10Params
+{
+  // The solver assumes a square field
+  std::size_t size{140};
+};
+
+// A rectangular loop starting at its top left corner, surrounded by a ring of ground and random pipes
+inline void generateDay10(std::ostream& out, const Day10Params& params, uint64_t seed = 1)
+{
+  static constexpr std::string_view junk = "|-LJ7F.";
+  if (params.size < 4) {
+    throw std::invalid_argument("Field too small for a loop");
+  }
+  SeededRng rng(seed);
+  auto x0 = static_cast<std::size_t>(rng.uniform(1, static_cast<int64_t>(params.size / 4)));
+  auto y0 = static_cast<std::size_t>(rng.uniform(1, static_cast<int64_t>(params.size / 4)));
+  auto x1 = params.size - 1 - static_cast<std::size_t>(rng.uniform(1, static_cast<int64_t>(params.size / 4)));
+  auto y1 = params.size - 1 - static_cast<std::size_t>(rng.uniform(1, static_cast<int64_t>(params.size / 4)));
+
+  std::string row;
+  for (std::size_t y = 0; y < params.size; y++) {
+    row.clear();
+    for (std::size_t x = 0; x < params.size; x++) {
+      bool onRing = (x + 1 >= x0 && x <= x1 + 1 && y + 1 >= y0 && y <= y1 + 1) &&
+                    (x + 1 == x0 || x == x1 + 1 || y + 1 == y0 || y == y1 + 1);
+      if (x == x0 && y == y0) {
+        row += 'S';
+      } else if (x == x1 && y == y0) {
+        row += '7';
+      } else if (x == x0 && y == y1) {
+        row += 'L';
+      } else if (x == x1 && y == y1) {
+        row += 'J';
+      } else if ((y == y0 || y == y1) && x > x0 && x < x1) {
+        row += '-';
+      } else if ((x == x0 || x == x1) && y > y0 && y < y1) {
+        row += '|';
+      } else if (onRing) {
+        row += '.';
+      } else {
+        row += junk[rng.index(junk.size())];
+      }
+    }
+    row += '\n';
+    out.write(row.data(), static_cast<std::streamsize>(row.size()));
+  }
+}
+
+struct Day11Params
+{
+  std::size_t width{140};
+  std::size_t height{140};
+  double galaxyDensity{0.02};
+  // Probability of a row without any galaxy
+  double emptyRowRatio{0.05};
+};
+
+// Rows are written one by one, so huge sparse maps need only O(width) memory
+inline void generateDay11(std::ostream& out, const Day11Params& params, uint64_t seed = 1)
+{
+  SeededRng rng(seed);
+  std::string row;
+  auto galaxiesPerRow =
+      std::max<int64_t>(1, static_cast<int64_t>(params.galaxyDensity * static_cast<double>(params.width)));
+  for (std::size_t y = 0; y < params.height; y++) {
+    row.assign(params.width, '.');
+    if (!rng.chance(params.emptyRowRatio)) {
+      auto count = rng.uniform(0, 2 * galaxiesPerRow);
+      for (int64_t i = 0; i < count; i++) {
+        row[rng.index(params.width)] = '#';
+      }
+    }
+    row += '\n';
+    out.write(row.data(), static_cast<std::streamsize>(row.size()));
+  }
+}
+
+struct Day12Params
+{
+  std::size_t rows{1000};
+  std::size_t maxGroups{6};
+  std::size_t maxGroupSize{5};
+  std::size_t maxGap{3};
+  double unknownRatio{0.5};
+};
+
+// Rows are built from a valid arrangement with some springs masked as unknown, so every row has at
+// least one arrangement
+inline void generateDay12(std::ostream& out, const Day12Params& params, uint64_t seed = 1)
+{
+  SeededRng rng(seed);
+  std::string springs;
+  std::string groups;
+  for (std::size_t r = 0; r < params.rows; r++) {
+    springs.assign(rng.index(params.maxGap + 1), '.');
+    groups.clear();
+    auto groupCount = rng.uniform(1, static_cast<int64_t>(params.maxGroups));
+    for (int64_t g = 0; g < groupCount; g++) {
+      auto size = static_cast<std::size_t>(rng.uniform(1, static_cast<int64_t>(params.maxGroupSize)));
+      springs.append(size, '#');
+      springs.append(g + 1 < groupCount ? 1 + rng.index(params.maxGap) : rng.index(params.maxGap + 1), '.');
+      if (g > 0) {
+        groups += ',';
+      }
+      groups += std::to_string(size);
+    }
+    for (auto& c : springs) {
+      if (rng.chance(params.unknownRatio)) {
+        c = '?';
+      }
+    }
+    springs += ' ';
+    springs += groups;
+    springs += '\n';
+    out.write(springs.data(), static_cast<std::streamsize>(springs.size()));
+  }
+}
+
+struct Day13Params
+{
+  std::size_t patterns{100};
+  std::size_t minSize{9};
+  std::size_t maxSize{17};
+};
+
+// Differing cells between the rows above row i and their mirror images below it (transposed: columns left of i)
+inline std::size_t day13MirrorDiffs(const std::vector<std::string>& rows, std::size_t i, bool transposed)
+{
+  const std::size_t length = transposed ? rows[0].size() : rows.size();
+  const std::size_t across = transposed ? rows.size() : rows[0].size();
+  std::size_t diffs = 0;
+  for (std::size_t k = 0; k < std::min(i, length - i); k++) {
+    for (std::size_t j = 0; j < across; j++) {
+      auto cell = [&](std::size_t at) { return transposed ? rows[j][at] : rows[at][j]; };
+      diffs += cell(i - 1 - k) != cell(i + k) ? 1 : 0;
+    }
+  }
+  return diffs;
+}
+
+// Every pattern has an exact vertical reflection (task1) and a horizontal reflection with exactly one
+// smudge (task2). The smudge lies in columns outside the vertical reflection, so it keeps the first one
+// intact. Patterns with any other reflection (exact or with one smudge) are drawn again, so the planted ones are
+// the answers, which are returned as {task1, task2}.
+inline std::pair<int64_t, int64_t> generateDay13(std::ostream& out, const Day13Params& params, uint64_t seed = 1)
+{
+  if (params.minSize < 5) {
+    throw std::invalid_argument("Patterns need to be at least 5x5");
+  }
+  SeededRng rng(seed);
+  auto randomSize = [&] {
+    auto size = rng.uniform(static_cast<int64_t>(params.minSize), static_cast<int64_t>(params.maxSize));
+    return static_cast<std::size_t>(size);
+  };
+
+  std::pair<int64_t, int64_t> answers{};
+  std::vector<std::string> rows;
+  for (std::size_t p = 0; p < params.patterns; p++) {
+    std::size_t c = 0;
+    std::size_t r = 0;
+    auto onlyPlanted = [&rows, &c, &r] {
+      for (std::size_t i = 1; i < rows[0].size(); i++) {
+        auto diffs = day13MirrorDiffs(rows, i, true);
+        if (i == c ? diffs != 0 : diffs <= 1) {
+          return false;
+        }
+      }
+      for (std::size_t i = 1; i < rows.size(); i++) {
+        auto diffs = day13MirrorDiffs(rows, i, false);
+        if (i == r ? diffs != 1 : diffs <= 1) {
+          return false;
+        }
+      }
+      return true;
+    };
+    do {
+      auto width = randomSize();
+      auto height = randomSize();
+      // Reflection between column c - 1 and c, columns >= 2c are not mirrored
+      c = static_cast<std::size_t>(rng.uniform(1, static_cast<int64_t>((width - 1) / 2)));
+      // Reflection between row r - 1 and r
+      r = static_cast<std::size_t>(rng.uniform(1, static_cast<int64_t>(height - 1)));
+
+      rows.assign(height, std::string(width, '.'));
+      for (auto& row : rows) {
+        for (auto& cell : row) {
+          cell = rng.chance(0.5) ? '#' : '.';
+        }
+        for (std::size_t k = 0; k < c; k++) {
+          row[c - 1 - k] = row[c + k];
+        }
+      }
+      auto window = std::min(r, height - r);
+      for (std::size_t k = 0; k < window; k++) {
+        rows[r + k] = rows[r - 1 - k];
+      }
+      auto& smudged = rows[r + rng.index(window)][2 * c + rng.index(width - 2 * c)];
+      smudged = smudged == '#' ? '.' : '#';
+    } while (!onlyPlanted());
+    answers.first += static_cast<int64_t>(c);
+    answers.second += 100 * static_cast<int64_t>(r);
+
+    if (p > 0) {
+      out.put('\n');
+    }
+    for (const auto& row : rows) {
+      out.write(row.data(), static_cast<std::streamsize>(row.size()));
+      out.put('\n');
+    }
+  }
+  return answers;
+}
+
+struct Day15Params
+{
+  std::size_t steps{4000};
+  std::size_t labels{500};
+  std::size_t maxLabelLength{6};
+  double removeRatio{0.3};
+};
+
+// One single line of comma separated steps, written in small pieces so multi GB streams need no memory
+inline void generateDay15(std::ostream& out, const Day15Params& params, uint64_t seed = 1)
+{
+  SeededRng rng(seed);
+  std::vector<std::string> labels(params.labels);
+  for (auto& label : labels) {
+    label.resize(static_cast<std::size_t>(rng.uniform(2, static_cast<int64_t>(params.maxLabelLength))));
+    for (auto& c : label) {
+      c = static_cast<char>('a' + rng.index(26));
+    }
+  }
+
+  std::string chunk;
+  for (std::size_t s = 0; s < params.steps; s++) {
+    if (s > 0) {
+      chunk += ',';
+    }
+    chunk += labels[rng.index(labels.size())];
+    if (rng.chance(params.removeRatio)) {
+      chunk += '-';
+    } else {
+      chunk += '=';
+      chunk += static_cast<char>('1' + rng.index(9));
+    }
+    if (chunk.size() >= 64 * 1024) {
+      out.write(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+      chunk.clear();
+    }
+  }
+  chunk += '\n';
+  out.write(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+}
+
+// Generators with a single size knob, scale 1 is roughly the size of a real puzzle input
+struct InputGenerator
+{
+  std::string_view day;
+  void (*generate)(std::ostream& out, std::size_t scale, uint64_t seed);
+};
+
+inline constexpr std::array<InputGenerator, 14> inputGenerators = {{
+    {"day1",
+     [](std::ostream& out, std::size_t scale, uint64_t seed) {
+       generateDay1(out, {.lines = 1000 * scale}, seed);
+     }},
+    {"day2",
+     [](std::ostream& out, std::size_t scale, uint64_t seed) {
+       generateDay2(out, {.games = 100 * scale}, seed);
+     }},
+    {"day3",
+     [](std::ostream& out, std::size_t scale, uint64_t seed) {
+       generateDay3(out, {.height = 140 * scale}, seed);
+     }},
+    {"day4",
+     [](std::ostream& out, std::size_t scale, uint64_t seed) {
+       generateDay4(out, {.cards = 200 * scale}, seed);
+     }},
+    {"day5",
+     [](std::ostream& out, std::size_t scale, uint64_t seed) {
+       generateDay5(out, {.mappingsPerStage = 40 * scale}, seed);
+     }},
+    {"day6",
+     [](std::ostream& out, std::size_t scale, uint64_t seed) {
+       generateDay6(out, {.races = 4 * scale}, seed);
+     }},
+    {"day7",
+     [](std::ostream& out, std::size_t scale, uint64_t seed) {
+       generateDay7(out, {.hands = std::min<std::size_t>(1000 * scale, 371293)}, seed);
+     }},
+    {"day8",
+     [](std::ostream& out, std::size_t scale, uint64_t seed) {
+       generateDay8(out, {.instructionLength = 300 * scale}, seed);
+     }},
+    {"day9",
+     [](std::ostream& out, std::size_t scale, uint64_t seed) {
+       generateDay9(out, {.sequences = 200 * scale}, seed);
+     }},
+    {"day10",
+     [](std::ostream& out, std::size_t scale, uint64_t seed) {
+       generateDay10(out, {.size = 140 * scale}, seed);
+     }},
+    {"day11",
+     [](std::ostream& out, std::size_t scale, uint64_t seed) {
+       generateDay11(out, {.width = 140 * scale, .height = 140 * scale}, seed);
+     }},
+    {"day12",
+     [](std::ostream& out, std::size_t scale, uint64_t seed) {
+       generateDay12(out, {.rows = 1000 * scale}, seed);
+     }},
+    {"day13",
+     [](std::ostream& out, std::size_t scale, uint64_t seed) {
+       generateDay13(out, {.patterns = 100 * scale}, seed);
+     }},
+    {"day15",
+     [](std::ostream& out, std::size_t scale, uint64_t seed) {
+       generateDay15(out, {.steps = 4000 * scale}, seed);
+     }},
+}};
@@ -0,0 +1,246 @@
+#pragma once
+
+#include "common.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+// Row major 2D grid in one contiguous block. Rows are stride elements apart, so a grid can either own its cells or
+// view memory laid out by someone else, e.g. the lines of a mapped input with the newline between them.
+//
+// An owning grid can be surrounded by a sentinel border of the given width: (x, y) is valid for
+// -border <= x < width + border and likewise for y. With a border of one, all eight neighbors of a cell can be read
+// without bounds checks. operator() is unchecked, at() throws std::out_of_range outside of the grid.
+template<class T>
+class Grid2D
+{
+public:
+  using value_type = std::remove_const_t<T>;
+
+  Grid2D() = default;
+
+  Grid2D(std::size_t width, std::size_t height, const value_type& fill = {}, std::size_t border = 0,
+         const value_type& borderValue = {})
+      : width_(width), height_(height), stride_(width + (2 * border)), border_(border),
+        storage_(stride_ * (height + (2 * border)), borderValue), originOffset_((border * stride_) + border)
+  {
+    for (std::size_t y = 0; y < height_; y++) {
+      std::fill_n(storage_.data() + rowOffset(y), width_, fill);
+    }
+  }
+
+  // Non-owning, origin points to (0, 0) and has to outlive the grid
+  static Grid2D view(T* origin, std::size_t width, std::size_t height, std::size_t stride)
+  {
+    Grid2D grid;
+    grid.width_ = width;
+    grid.height_ = height;
+    grid.stride_ = stride;
+    grid.external_ = origin;
+    return grid;
+  }
+
+  // Copies the lines through convert(char), rows shorter than the longest one are padded with borderValue
+  template<class Convert = std::identity>
+  static Grid2D fromLines(Lines lines, std::size_t border = 0, const value_type& borderValue = {},
+                          Convert convert = {})
+  {
+    std::size_t width = 0;
+    for (auto line : lines) {
+      width = std::max(width, line.size());
+    }
+    Grid2D grid(width, lines.size(), borderValue, border, borderValue);
+    for (std::size_t y = 0; y < lines.size(); y++) {
+      // Through the storage, so this also works for grids of const cells
+      std::ranges::transform(lines[y], grid.storage_.begin() + static_cast<std::ptrdiff_t>(grid.rowOffset(y)), convert);
+    }
+    return grid;
+  }
+
+  std::size_t width() const
+  {
+    return width_;
+  }
+
+  std::size_t height() const
+  {
+    return height_;
+  }
+
+  std::size_t stride() const
+  {
+    return stride_;
+  }
+
+  std::size_t border() const
+  {
+    return border_;
+  }
+
+  bool isView() const
+  {
+    return external_ != nullptr;
+  }
+
+  // Inside the grid proper, the border does not count
+  bool contains(std::ptrdiff_t x, std::ptrdiff_t y) const
+  {
+    return x >= 0 && y >= 0 && static_cast<std::size_t>(x) < width_ && static_cast<std::size_t>(y) < height_;
+  }
+
+  T& operator()(std::ptrdiff_t x, std::ptrdiff_t y)
+  {
+    return origin()[(y * static_cast<std::ptrdiff_t>(stride_)) + x];
+  }
+
+  const T& operator()(std::ptrdiff_t x, std::ptrdiff_t y) const
+  {
+    return origin()[(y * static_cast<std::ptrdiff_t>(stride_)) + x];
+  }
+
+  T& at(std::ptrdiff_t x, std::ptrdiff_t y)
+  {
+    checkBounds(x, y);
+    return (*this)(x, y);
+  }
+
+  const T& at(std::ptrdiff_t x, std::ptrdiff_t y) const
+  {
+    checkBounds(x, y);
+    return (*this)(x, y);
+  }
+
+  std::span<T> row(std::size_t y)
+  {
+    return {origin() + (y * stride_), width_};
+  }
+
+  std::span<const T> row(std::size_t y) const
+  {
+    return {origin() + (y * stride_), width_};
+  }
+
+  auto rows() const
+  {
+    return std::views::iota(std::size_t{0}, height_) | std::views::transform([this](std::size_t y) { return row(y); });
+  }
+
+  // Strided and therefore slow to walk over large grids, prefer rows of the transposed grid for repeated use
+  auto column(std::size_t x) const
+  {
+    return std::views::iota(std::size_t{0}, height_) |
+           std::views::transform([cell = origin() + x, stride = stride_](std::size_t y) -> const T& {
+             return cell[y * stride];
+           });
+  }
+
+  // Owning copy with rows and columns swapped, the border is transposed along. Walks the grid in square tiles so
+  // reads and writes both stay within a few cache lines.
+  Grid2D<value_type> transposed(std::size_t blockSize = 32) const
+  {
+    Grid2D<value_type> result(height_, width_, value_type{}, border_);
+    auto border = static_cast<std::ptrdiff_t>(border_);
+    auto fullWidth = static_cast<std::ptrdiff_t>(width_) + border;
+    auto fullHeight = static_cast<std::ptrdiff_t>(height_) + border;
+    auto block = static_cast<std::ptrdiff_t>(std::max<std::size_t>(blockSize, 1));
+    for (std::ptrdiff_t by = -border; by < fullHeight; by += block) {
+      for (std::ptrdiff_t bx = -border; bx < fullWidth; bx += block) {
+        for (std::ptrdiff_t y = by; y < std::min(by + block, fullHeight); y++) {
+          for (std::ptrdiff_t x = bx; x < std::min(bx + block, fullWidth); x++) {
+            result(y, x) = (*this)(x, y);
+          }
+        }
+      }
+    }
+    return result;
+  }
+
+private:
+  T* origin()
+  {
+    return external_ != nullptr ? external_ : storage_.data() + originOffset_;
+  }
+
+  const T* origin() const
+  {
+    return external_ != nullptr ? external_ : storage_.data() + originOffset_;
+  }
+
+  std::size_t rowOffset(std::size_t y) const
+  {
+    return originOffset_ + (y * stride_);
+  }
+
+  void checkBounds(std::ptrdiff_t x, std::ptrdiff_t y) const
+  {
+    auto border = static_cast<std::ptrdiff_t>(border_);
+    if (x < -border || y < -border || x >= static_cast<std::ptrdiff_t>(width_) + border ||
+        y >= static_cast<std::ptrdiff_t>(height_) + border) {
+      throw std::out_of_range("Grid position out of range: " + std::to_string(x) + "," + std::to_string(y));
+    }
+  }
+
+  std::size_t width_{};
+  std::size_t height_{};
+  std::size_t stride_{};
+  std::size_t border_{};
+  // Owning grids keep an offset instead of a pointer, so copies and moves need no fix up
+  std::vector<value_type> storage_;
+  std::size_t originOffset_{};
+  T* external_{nullptr};
+};
+
+using CharGrid = Grid2D<const char>;
+
+// Character grid over lines of equal length, the lines are copied
+inline CharGrid charGrid(Lines lines)
+{
+  for (auto line : lines) {
+    if (line.size() != lines[0].size()) {
+      throw std::runtime_error("Grid rows differ in length");
+    }
+  }
+  return CharGrid::fromLines(lines);
+}
+
+// Character grid over lines of equal length that all point into buffer, like those of a MappedInput or its
+// splitOnEmptyRows blocks. They are viewed in place if they follow each other at a constant stride, otherwise (or
+// if a line is not inside of buffer) they are copied.
+inline CharGrid charGrid(Lines lines, std::string_view buffer)
+{
+  if (lines.empty()) {
+    return {};
+  }
+  // Compared as integers, lines which are not inside of buffer must not take part in pointer arithmetic
+  auto address = [](std::string_view line) { return reinterpret_cast<std::uintptr_t>(line.data()); };
+  const std::uintptr_t bufferBegin = address(buffer);
+  const std::uintptr_t bufferEnd = bufferBegin + buffer.size();
+  const std::size_t width = lines[0].size();
+  const std::uintptr_t first = address(lines[0]);
+  const std::uintptr_t second = lines.size() > 1 ? address(lines[1]) : first + width;
+  const std::size_t stride = second > first ? second - first : 0;
+  bool inPlace = stride >= width;
+  for (std::size_t y = 0; y < lines.size() && inPlace; y++) {
+    auto begin = address(lines[y]);
+    inPlace = lines[y].size() == width && begin == first + (y * stride) && begin >= bufferBegin &&
+              begin + width <= bufferEnd;
+  }
+  if (inPlace) {
+    return CharGrid::view(lines[0].data(), width, lines.size(), stride);
+  }
+  return charGrid(lines);
+}
+
+inline CharGrid charGrid(const MappedInput& input)
+{
+  return charGrid(input.lines(), input.data());
+}
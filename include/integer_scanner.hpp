@@ -0,0 +1,199 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define AOC_SCANNER_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define AOC_SCANNER_SSE2 1
+#endif
+
+// Vectorized scanner for whitespace (or anything else) separated integers. Digits are classified 64 bytes at a
+// time (AVX2, SSE2 or a scalar fallback) into a bitmask, digit runs are found with bit tricks on that mask and
+// converted eight digits at a time with SWAR multiplications. A '-' directly in front of a run negates it, every
+// other non-digit character is a separator. A run whose value does not fit into int64_t throws
+// std::out_of_range instead of wrapping around.
+
+namespace scanner_detail
+{
+// Bit i is set if p[i] is a digit, count <= 64
+inline uint64_t digitMask(const char* p, std::size_t count)
+{
+  if (count == 64) {
+#if defined(AOC_SCANNER_AVX2)
+    const __m256i zero = _mm256_set1_epi8('0');
+    const __m256i nine = _mm256_set1_epi8(9);
+    auto classify = [&](const char* block) {
+      __m256i offset = _mm256_sub_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(block)), zero);
+      // Unsigned offset <= 9 <=> min(offset, 9) == offset
+      return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_min_epu8(offset, nine), offset)));
+    };
+    return static_cast<uint64_t>(classify(p)) | (static_cast<uint64_t>(classify(p + 32)) << 32);
+#elif defined(AOC_SCANNER_SSE2)
+    const __m128i zero = _mm_set1_epi8('0');
+    const __m128i nine = _mm_set1_epi8(9);
+    uint64_t mask = 0;
+    for (std::size_t i = 0; i < 64; i += 16) {
+      __m128i offset = _mm_sub_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i)), zero);
+      auto bits = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(offset, nine), offset)));
+      mask |= static_cast<uint64_t>(bits) << i;
+    }
+    return mask;
+#endif
+  }
+
+  uint64_t mask = 0;
+  for (std::size_t i = 0; i < count; i++) {
+    mask |= static_cast<uint64_t>(static_cast<unsigned char>(p[i] - '0') < 10) << i;
+  }
+  return mask;
+}
+
+// Bit i is set if p[i] == c, count <= 64
+inline uint64_t byteMask(const char* p, std::size_t count, char c)
+{
+  if (count == 64) {
+#if defined(AOC_SCANNER_AVX2)
+    const __m256i needle = _mm256_set1_epi8(c);
+    auto classify = [&](const char* block) {
+      __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+      return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, needle)));
+    };
+    return static_cast<uint64_t>(classify(p)) | (static_cast<uint64_t>(classify(p + 32)) << 32);
+#elif defined(AOC_SCANNER_SSE2)
+    const __m128i needle = _mm_set1_epi8(c);
+    uint64_t mask = 0;
+    for (std::size_t i = 0; i < 64; i += 16) {
+      __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+      auto bits = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, needle)));
+      mask |= static_cast<uint64_t>(bits) << i;
+    }
+    return mask;
+#endif
+  }
+
+  uint64_t mask = 0;
+  for (std::size_t i = 0; i < count; i++) {
+    mask |= static_cast<uint64_t>(p[i] == c) << i;
+  }
+  return mask;
+}
+
+// Converts up to eight digits, end limits how far past p may be read
+inline uint64_t parseEightDigits(const char* p, std::size_t length, const char* end)
+{
+  uint64_t chunk = 0;
+  if (end - p >= 8) {
+    std::memcpy(&chunk, p, 8);
+  } else {
+    std::memcpy(&chunk, p, length);
+  }
+  // Drops the bytes behind the run, the freed low bytes become leading zeros
+  chunk <<= 8 * (8 - length);
+  chunk = ((chunk & 0x0F0F0F0F0F0F0F0F) * 2561) >> 8;
+  chunk = ((chunk & 0x00FF00FF00FF00FF) * 6553601) >> 16;
+  return ((chunk & 0x0000FFFF0000FFFF) * 42949672960001) >> 32;
+}
+
+inline uint64_t parseDigits(const char* p, std::size_t length, const char* end)
+{
+  if constexpr (std::endian::native == std::endian::little) {
+    if (length <= 8) {
+      return parseEightDigits(p, length, end);
+    }
+    if (length <= 16) {
+      return parseEightDigits(p, length - 8, end) * 100000000 + parseEightDigits(p + length - 8, 8, end);
+    }
+  }
+  // Long runs (or big endian hosts), only here a value can leave the int64_t range
+  constexpr auto limit = static_cast<uint64_t>(std::numeric_limits<int64_t>::max());
+  uint64_t value = 0;
+  for (std::size_t i = 0; i < length; i++) {
+    auto digit = static_cast<uint64_t>(p[i] - '0');
+    if (value > (limit - digit) / 10) {
+      throw std::out_of_range("Integer does not fit into int64_t: " + std::string(p, length));
+    }
+    value = value * 10 + digit;
+  }
+  return value;
+}
+}  // namespace scanner_detail
+
+// Calls fn(int64_t) for every integer in text, in order
+template<class Fn>
+void forEachInteger(std::string_view text, Fn&& fn)
+{
+  const char* data = text.data();
+  const char* end = data + text.size();
+  auto emit = [&](std::size_t start, std::size_t stop) {
+    auto magnitude = static_cast<int64_t>(scanner_detail::parseDigits(data + start, stop - start, end));
+    fn(start > 0 && data[start - 1] == '-' ? -magnitude : magnitude);
+  };
+
+  // Runs can cross window borders, runStart is only valid while inRun
+  bool inRun = false;
+  std::size_t runStart = 0;
+  for (std::size_t base = 0; base < text.size(); base += 64) {
+    auto count = std::min<std::size_t>(64, text.size() - base);
+    uint64_t digits = scanner_detail::digitMask(data + base, count);
+    uint64_t previous = (digits << 1) | static_cast<uint64_t>(inRun);
+    uint64_t starts = digits & ~previous;
+    uint64_t ends = ~digits & previous;
+    if (count < 64) {
+      ends &= (uint64_t{1} << count) - 1;
+    }
+
+    // Starts and ends alternate, so the lowest pending event is always the next one
+    uint64_t events = starts | ends;
+    while (events != 0) {
+      auto bit = static_cast<std::size_t>(std::countr_zero(events));
+      events &= events - 1;
+      if (inRun) {
+        emit(runStart, base + bit);
+      } else {
+        runStart = base + bit;
+      }
+      inRun = !inRun;
+    }
+  }
+  if (inRun) {
+    emit(runStart, text.size());
+  }
+}
+
+// Appends every integer of text to out (anything with push_back), returns the number of integers appended
+template<class Container>
+std::size_t scanIntegers(std::string_view text, Container& out)
+{
+  std::size_t count = 0;
+  forEachInteger(text, [&](int64_t value) {
+    out.push_back(static_cast<typename Container::value_type>(value));
+    count++;
+  });
+  return count;
+}
+
+// Writes the first out.size() integers of text into the caller's buffer, returns how many integers text holds
+template<class T, std::size_t Extent>
+std::size_t scanIntegers(std::string_view text, std::span<T, Extent> out)
+{
+  std::size_t count = 0;
+  forEachInteger(text, [&](int64_t value) {
+    if (count < out.size()) {
+      out[count] = static_cast<T>(value);
+    }
+    count++;
+  });
+  return count;
+}
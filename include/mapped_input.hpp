@@ -0,0 +1,212 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define AOC_HAS_MMAP 1
+#else
+#include <fstream>
+#endif
+
+// Splits a buffer into lines with std::getline semantics: no line terminators are included and a
+// trailing newline does not produce an extra empty line.
+inline std::vector<std::string_view> splitLines(std::string_view buffer)
+{
+  std::vector<std::string_view> lines;
+  const char* cursor = buffer.data();
+  const char* end = buffer.data() + buffer.size();
+  while (cursor < end) {
+    const auto* newline = static_cast<const char*>(std::memchr(cursor, '\n', static_cast<std::size_t>(end - cursor)));
+    if (newline == nullptr) {
+      newline = end;
+    }
+    lines.emplace_back(cursor, static_cast<std::size_t>(newline - cursor));
+    cursor = newline + 1;
+  }
+  return lines;
+}
+
+// Read-only, zero-copy view of an input file. On POSIX the file is mmap'ed and every line is a
+// std::string_view into the mapping, elsewhere the file is read into one buffer. The object owns the
+// memory, so the lines are only valid as long as the MappedInput is alive.
+class MappedInput
+{
+public:
+  enum class AccessHint
+  {
+    Normal,
+    Sequential,
+    HugePages,
+  };
+
+  explicit MappedInput(const std::filesystem::path& path, AccessHint hint = AccessHint::Sequential)
+  {
+#ifdef AOC_HAS_MMAP
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      throw std::runtime_error("Could not open input file: " + path.string());
+    }
+
+    struct stat fileStat{};
+    if (::fstat(fd, &fileStat) != 0) {
+      ::close(fd);
+      throw std::runtime_error("Could not stat input file: " + path.string());
+    }
+
+    mappedSize_ = static_cast<std::size_t>(fileStat.st_size);
+    if (mappedSize_ > 0) {
+      void* mapping = ::mmap(nullptr, mappedSize_, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (mapping == MAP_FAILED) {
+        ::close(fd);
+        throw std::runtime_error("Could not map input file: " + path.string());
+      }
+      mapping_ = mapping;
+      adviseKernel(hint);
+    }
+    ::close(fd);
+
+    data_ = std::string_view(static_cast<const char*>(mapping_), mappedSize_);
+#else
+    (void)hint;
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+      throw std::runtime_error("Could not open input file: " + path.string());
+    }
+    buffer_.resize(static_cast<std::size_t>(std::filesystem::file_size(path)));
+    file.read(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+    data_ = std::string_view(buffer_.data(), buffer_.size());
+#endif
+    lines_ = splitLines(data_);
+  }
+
+  // Takes ownership of input bytes that did not come from a file, e.g. received over a socket
+  explicit MappedInput(std::vector<char> buffer) : buffer_(std::move(buffer))
+  {
+    data_ = std::string_view(buffer_.data(), buffer_.size());
+    lines_ = splitLines(data_);
+  }
+
+  MappedInput(const MappedInput&) = delete;
+  MappedInput& operator=(const MappedInput&) = delete;
+
+  MappedInput(MappedInput&& other) noexcept
+      : mapping_(std::exchange(other.mapping_, nullptr)), mappedSize_(std::exchange(other.mappedSize_, 0)),
+        buffer_(std::move(other.buffer_)), data_(std::exchange(other.data_, {})), lines_(std::move(other.lines_))
+  {
+  }
+
+  MappedInput& operator=(MappedInput&& other) noexcept
+  {
+    if (this != &other) {
+      unmap();
+      mapping_ = std::exchange(other.mapping_, nullptr);
+      mappedSize_ = std::exchange(other.mappedSize_, 0);
+      buffer_ = std::move(other.buffer_);
+      data_ = std::exchange(other.data_, {});
+      lines_ = std::move(other.lines_);
+    }
+    return *this;
+  }
+
+  ~MappedInput()
+  {
+    unmap();
+  }
+
+  // Whole file content
+  std::string_view data() const
+  {
+    return data_;
+  }
+
+  std::span<const std::string_view> lines() const
+  {
+    return lines_;
+  }
+
+  std::size_t size() const
+  {
+    return lines_.size();
+  }
+
+  bool empty() const
+  {
+    return lines_.empty();
+  }
+
+  const std::string_view& operator[](std::size_t index) const
+  {
+    return lines_[index];
+  }
+
+  const std::string_view& front() const
+  {
+    return lines_.front();
+  }
+
+  const std::string_view& back() const
+  {
+    return lines_.back();
+  }
+
+  auto begin() const
+  {
+    return lines_.begin();
+  }
+
+  auto end() const
+  {
+    return lines_.end();
+  }
+
+private:
+  void adviseKernel([[maybe_unused]] AccessHint hint)
+  {
+#ifdef AOC_HAS_MMAP
+    // Only hints, failures are not fatal
+    switch (hint) {
+    case AccessHint::Normal:
+      break;
+    case AccessHint::Sequential:
+      ::madvise(mapping_, mappedSize_, MADV_SEQUENTIAL);
+      ::madvise(mapping_, mappedSize_, MADV_WILLNEED);
+      break;
+    case AccessHint::HugePages:
+#ifdef MADV_HUGEPAGE
+      ::madvise(mapping_, mappedSize_, MADV_HUGEPAGE);
+#endif
+      ::madvise(mapping_, mappedSize_, MADV_SEQUENTIAL);
+      break;
+    }
+#endif
+  }
+
+  void unmap()
+  {
+#ifdef AOC_HAS_MMAP
+    if (mapping_ != nullptr) {
+      ::munmap(mapping_, mappedSize_);
+    }
+#endif
+    mapping_ = nullptr;
+    mappedSize_ = 0;
+  }
+
+  void* mapping_{nullptr};
+  std::size_t mappedSize_{};
+  std::vector<char> buffer_;
+  std::string_view data_;
+  std::vector<std::string_view> lines_;
+};
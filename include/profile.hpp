@@ -0,0 +1,192 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fmt/format.h>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Scoped profiling zones, exported as Chrome trace JSON that chrome://tracing and ui.perfetto.dev open.
+//
+// Zones are only compiled in when AOC_PROFILE is defined (cmake -DAOC_PROFILE=ON), otherwise AOC_PROFILE_ZONE
+// expands to nothing. A compiled in zone records only after profile::enable(), until then it costs one relaxed
+// atomic load. Every thread appends to its own buffer, so recording takes no lock; export the trace once the
+// recording threads are idle.
+//
+// Zone names must outlive the export, string literals or __func__.
+
+#ifdef AOC_PROFILE
+#define AOC_PROFILE_CONCAT_IMPL(a, b) a##b
+#define AOC_PROFILE_CONCAT(a, b) AOC_PROFILE_CONCAT_IMPL(a, b)
+#define AOC_PROFILE_ZONE(name) const ::profile::Zone AOC_PROFILE_CONCAT(profileZone, __LINE__)(name)
+#define AOC_PROFILE_FUNCTION() AOC_PROFILE_ZONE(__func__)
+#else
+#define AOC_PROFILE_ZONE(name) static_cast<void>(0)
+#define AOC_PROFILE_FUNCTION() static_cast<void>(0)
+#endif
+
+namespace profile
+{
+#ifdef AOC_PROFILE
+inline constexpr bool compiledIn = true;
+#else
+inline constexpr bool compiledIn = false;
+#endif
+
+using Clock = std::chrono::steady_clock;
+
+struct Event
+{
+  std::string_view name;
+  int64_t startNs{};
+  int64_t durationNs{};
+};
+
+struct ThreadEvents
+{
+  std::size_t id{};
+  std::string name;
+  std::vector<Event> events;
+};
+
+// Constant initialized, so zones in static initializers of other translation units see a valid flag
+inline std::atomic<bool> recording{false};
+
+class Registry
+{
+public:
+  static Registry& instance()
+  {
+    static Registry registry;
+    return registry;
+  }
+
+  Clock::time_point epoch() const
+  {
+    return epoch_;
+  }
+
+  // Buffer of the calling thread, registered on first use and kept after the thread exits
+  ThreadEvents& threadEvents()
+  {
+    thread_local ThreadEvents* events = nullptr;
+    if (events == nullptr) {
+      std::lock_guard lock(mutex_);
+      auto id = threads_.size();
+      threads_.push_back(
+          std::make_unique<ThreadEvents>(ThreadEvents{.id = id, .name = fmt::format("thread {}", id), .events = {}}));
+      events = threads_.back().get();
+    }
+    return *events;
+  }
+
+  void writeChromeTrace(std::ostream& out) const
+  {
+    std::lock_guard lock(mutex_);
+    out << R"({"displayTimeUnit":"ns","traceEvents":[)";
+    bool first = true;
+    auto separator = [&first]() {
+      return std::exchange(first, false) ? "\n" : ",\n";
+    };
+    for (const auto& thread : threads_) {
+      out << separator()
+          << fmt::format(R"({{"name":"thread_name","ph":"M","pid":1,"tid":{},"args":{{"name":"{}"}}}})", thread->id,
+                         escape(thread->name));
+      for (const auto& event : thread->events) {
+        out << separator()
+            << fmt::format(R"({{"name":"{}","cat":"aoc","ph":"X","pid":1,"tid":{},"ts":{:.3f},"dur":{:.3f}}})",
+                           escape(event.name), thread->id, static_cast<double>(event.startNs) / 1e3,
+                           static_cast<double>(event.durationNs) / 1e3);
+      }
+    }
+    out << "\n]}\n";
+  }
+
+private:
+  static std::string escape(std::string_view str)
+  {
+    std::string escaped;
+    for (char c : str) {
+      if (c == '"' || c == '\\') {
+        escaped += '\\';
+      }
+      escaped += c;
+    }
+    return escaped;
+  }
+
+  Clock::time_point epoch_{Clock::now()};
+  mutable std::mutex mutex_;
+  std::vector<std::unique_ptr<ThreadEvents>> threads_;
+};
+
+inline void enable()
+{
+  Registry::instance();  // Fixes the epoch before the first zone
+  recording.store(true, std::memory_order_relaxed);
+}
+
+inline bool enabled()
+{
+  return recording.load(std::memory_order_relaxed);
+}
+
+// Shown instead of "thread N" in the trace viewer
+inline void setThreadName(std::string name)
+{
+  if (enabled()) {
+    Registry::instance().threadEvents().name = std::move(name);
+  }
+}
+
+inline void writeChromeTrace(const std::filesystem::path& path)
+{
+  std::ofstream file(path, std::ios::binary);
+  if (!file.is_open()) {
+    throw std::runtime_error("Could not open trace file: " + path.string());
+  }
+  Registry::instance().writeChromeTrace(file);
+}
+
+class Zone
+{
+public:
+  explicit Zone(std::string_view name) : name_(name)
+  {
+    if (enabled()) {
+      active_ = true;
+      start_ = Clock::now();
+    }
+  }
+
+  Zone(const Zone&) = delete;
+  Zone& operator=(const Zone&) = delete;
+
+  ~Zone()
+  {
+    if (active_) {
+      auto end = Clock::now();
+      auto& registry = Registry::instance();
+      registry.threadEvents().events.push_back(
+          {.name = name_,
+           .startNs = std::chrono::duration_cast<std::chrono::nanoseconds>(start_ - registry.epoch()).count(),
+           .durationNs = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start_).count()});
+    }
+  }
+
+private:
+  std::string_view name_;
+  bool active_{false};
+  Clock::time_point start_;
+};
+}  // namespace profile
@@ -0,0 +1,204 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <initializer_list>
+#include <memory>
+#include <utility>
+
+// Vector keeping up to N elements inline, it only allocates once it grows beyond that. Meant for short per-record
+// lists (the drawings of a game, the gears next to a number) that would otherwise cost one malloc each. Elements
+// must be default constructible, unused slots hold value initialized elements.
+template<class T, std::size_t N>
+class SmallVector
+{
+public:
+  using value_type = T;
+  using size_type = std::size_t;
+  using iterator = T*;
+  using const_iterator = const T*;
+
+  SmallVector() = default;
+
+  SmallVector(std::initializer_list<T> values)
+  {
+    reserve(values.size());
+    std::copy(values.begin(), values.end(), data());
+    size_ = values.size();
+  }
+
+  SmallVector(const SmallVector& other)
+  {
+    reserve(other.size_);
+    std::copy(other.begin(), other.end(), data());
+    size_ = other.size_;
+  }
+
+  SmallVector(SmallVector&& other) noexcept
+      : inline_(std::move(other.inline_)), heap_(std::move(other.heap_)),
+        capacity_(std::exchange(other.capacity_, N)), size_(std::exchange(other.size_, 0))
+  {
+  }
+
+  SmallVector& operator=(const SmallVector& other)
+  {
+    if (this != &other) {
+      size_ = 0;
+      reserve(other.size_);
+      std::copy(other.begin(), other.end(), data());
+      size_ = other.size_;
+    }
+    return *this;
+  }
+
+  SmallVector& operator=(SmallVector&& other) noexcept
+  {
+    if (this != &other) {
+      inline_ = std::move(other.inline_);
+      heap_ = std::move(other.heap_);
+      capacity_ = std::exchange(other.capacity_, N);
+      size_ = std::exchange(other.size_, 0);
+    }
+    return *this;
+  }
+
+  ~SmallVector() = default;
+
+  void reserve(std::size_t capacity)
+  {
+    if (capacity <= capacity_) {
+      return;
+    }
+    auto grown = std::make_unique<T[]>(capacity);
+    std::move(begin(), end(), grown.get());
+    heap_ = std::move(grown);
+    capacity_ = capacity;
+  }
+
+  template<class... Args>
+  T& emplace_back(Args&&... args)
+  {
+    // Built before growing, args may refer to an element of this vector
+    T value(std::forward<Args>(args)...);
+    if (size_ == capacity_) {
+      reserve(std::max<std::size_t>(2 * capacity_, 1));
+    }
+    auto& element = data()[size_++];
+    element = std::move(value);
+    return element;
+  }
+
+  void push_back(const T& value)
+  {
+    emplace_back(value);
+  }
+
+  void push_back(T&& value)
+  {
+    emplace_back(std::move(value));
+  }
+
+  void pop_back()
+  {
+    size_--;
+  }
+
+  // Keeps the capacity, an allocated buffer is reused
+  void clear()
+  {
+    size_ = 0;
+  }
+
+  T* data()
+  {
+    return heap_ ? heap_.get() : inline_.data();
+  }
+
+  const T* data() const
+  {
+    return heap_ ? heap_.get() : inline_.data();
+  }
+
+  std::size_t size() const
+  {
+    return size_;
+  }
+
+  std::size_t capacity() const
+  {
+    return capacity_;
+  }
+
+  bool empty() const
+  {
+    return size_ == 0;
+  }
+
+  // True as long as no element spilled to the heap
+  bool isInline() const
+  {
+    return !heap_;
+  }
+
+  T& operator[](std::size_t index)
+  {
+    return data()[index];
+  }
+
+  const T& operator[](std::size_t index) const
+  {
+    return data()[index];
+  }
+
+  T& front()
+  {
+    return data()[0];
+  }
+
+  const T& front() const
+  {
+    return data()[0];
+  }
+
+  T& back()
+  {
+    return data()[size_ - 1];
+  }
+
+  const T& back() const
+  {
+    return data()[size_ - 1];
+  }
+
+  iterator begin()
+  {
+    return data();
+  }
+
+  iterator end()
+  {
+    return data() + size_;
+  }
+
+  const_iterator begin() const
+  {
+    return data();
+  }
+
+  const_iterator end() const
+  {
+    return data() + size_;
+  }
+
+  bool operator==(const SmallVector& other) const
+  {
+    return std::equal(begin(), end(), other.begin(), other.end());
+  }
+
+private:
+  std::array<T, N> inline_{};
+  std::unique_ptr<T[]> heap_;
+  std::size_t capacity_{N};
+  std::size_t size_{};
+};
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "solvers.hpp"
+
+#include <array>
+#include <string_view>
+
+// All days linked into the aoc runner. Kept apart from solvers.hpp, which every day includes, because referencing
+// the table requires the solver objects of all days.
+
+struct DaySolver
+{
+  std::string_view day;
+  Solver solve;
+};
+
+inline constexpr std::array<DaySolver, 14> daySolvers = {{
+    {"day1", day1::solve},
+    {"day2", day2::solve},
+    {"day3", day3::solve},
+    {"day4", day4::solve},
+    {"day5", day5::solve},
+    {"day6", day6::solve},
+    {"day7", day7::solve},
+    {"day8", day8::solve},
+    {"day9", day9::solve},
+    {"day10", day10::solve},
+    {"day11", day11::solve},
+    {"day12", day12::solve},
+    {"day13", day13::solve},
+    {"day15", day15::solve},
+}};
+
+// Accepts "dayN" as well as just "N"
+inline const DaySolver* findDaySolver(std::string_view name)
+{
+  for (const auto& solver : daySolvers) {
+    if (solver.day == name || solver.day.substr(3) == name) {
+      return &solver;
+    }
+  }
+  return nullptr;
+}
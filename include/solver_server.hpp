@@ -0,0 +1,499 @@
+#pragma once
+
+#include "bench.hpp"
+#include "mapped_input.hpp"
+#include "solver_registry.hpp"
+#include "solvers.hpp"
+#include "work_stealing_pool.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <filesystem>
+#include <fmt/core.h>
+#include <fmt/format.h>
+#include <istream>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#define AOC_HAS_UNIX_SOCKETS 1
+#endif
+
+// Framing used by the solver server, one text header line per message:
+//   request:  <id> <day> <1|2|both> <byte count>\n<input bytes>
+//   response: <id> ok <task1|-> <task2|-> <queue us> <solve us>\n
+//             <id> error <message>\n
+// Responses are written as soon as a request is solved, so they can arrive out of order; the id correlates them.
+
+struct RequestHeader
+{
+  uint64_t id{};
+  std::string day;
+  TaskSelection tasks;
+  std::size_t size{};
+};
+
+inline std::string formatRequestHeader(uint64_t id, std::string_view day, TaskSelection tasks, std::size_t size)
+{
+  std::string_view selection = tasks.task1 && tasks.task2 ? "both" : (tasks.task1 ? "1" : "2");
+  return fmt::format("{} {} {} {}\n", id, day, selection, size);
+}
+
+inline std::vector<std::string_view> splitWords(std::string_view line)
+{
+  std::vector<std::string_view> words;
+  std::size_t pos = 0;
+  while (pos < line.size()) {
+    auto end = line.find(' ', pos);
+    if (end == std::string_view::npos) {
+      end = line.size();
+    }
+    if (end > pos) {
+      words.push_back(line.substr(pos, end - pos));
+    }
+    pos = end + 1;
+  }
+  return words;
+}
+
+template<class T>
+std::optional<T> parseNumber(std::string_view str)
+{
+  T value{};
+  auto [ptr, ec] = std::from_chars(str.data(), str.data() + str.size(), value);
+  if (ec != std::errc{} || ptr != str.data() + str.size()) {
+    return std::nullopt;
+  }
+  return value;
+}
+
+// Throws if the header cannot be parsed, the frame boundary is lost in that case
+inline RequestHeader parseRequestHeader(std::string_view line)
+{
+  auto words = splitWords(line);
+  if (words.size() != 4) {
+    throw std::runtime_error(fmt::format("Invalid request header: '{}'", line));
+  }
+  auto id = parseNumber<uint64_t>(words[0]);
+  auto size = parseNumber<std::size_t>(words[3]);
+  if (!id || !size || (words[2] != "1" && words[2] != "2" && words[2] != "both")) {
+    throw std::runtime_error(fmt::format("Invalid request header: '{}'", line));
+  }
+  return {.id = *id,
+          .day = std::string(words[1]),
+          .tasks = {.task1 = words[2] != "2", .task2 = words[2] != "1"},
+          .size = *size};
+}
+
+// Byte stream requests are read from and responses are written to
+class Connection
+{
+public:
+  virtual ~Connection() = default;
+
+  // Returns false if the stream ended before the first byte of the line
+  virtual bool readLine(std::string& line) = 0;
+  // Throws if the stream ends early
+  virtual void readExact(char* data, std::size_t size) = 0;
+  virtual void write(std::string_view data) = 0;
+};
+
+// Works everywhere, used for stdin/stdout where there are no file descriptors
+class StreamConnection final : public Connection
+{
+public:
+  StreamConnection(std::istream& in, std::ostream& out) : in_(in), out_(out)
+  {
+  }
+
+  bool readLine(std::string& line) override
+  {
+    return static_cast<bool>(std::getline(in_, line));
+  }
+
+  void readExact(char* data, std::size_t size) override
+  {
+    in_.read(data, static_cast<std::streamsize>(size));
+    if (static_cast<std::size_t>(in_.gcount()) != size) {
+      throw std::runtime_error("Unexpected end of stream");
+    }
+  }
+
+  void write(std::string_view data) override
+  {
+    out_.write(data.data(), static_cast<std::streamsize>(data.size()));
+    out_.flush();
+  }
+
+private:
+  std::istream& in_;
+  std::ostream& out_;
+};
+
+#ifdef AOC_HAS_UNIX_SOCKETS
+// Buffered reads and unbuffered writes on file descriptors, e.g. a socket or stdin/stdout
+class FdConnection final : public Connection
+{
+public:
+  FdConnection(int readFd, int writeFd, bool owning = false)
+      : readFd_(readFd), writeFd_(writeFd), owning_(owning), buffer_(64 * 1024)
+  {
+  }
+
+  FdConnection(const FdConnection&) = delete;
+  FdConnection& operator=(const FdConnection&) = delete;
+
+  ~FdConnection() override
+  {
+    if (owning_) {
+      ::close(readFd_);
+      if (writeFd_ != readFd_) {
+        ::close(writeFd_);
+      }
+    }
+  }
+
+  bool readLine(std::string& line) override
+  {
+    line.clear();
+    while (true) {
+      const auto* begin = buffer_.data() + begin_;
+      const auto* newline = static_cast<const char*>(std::memchr(begin, '\n', end_ - begin_));
+      if (newline != nullptr) {
+        line.append(begin, newline);
+        begin_ += static_cast<std::size_t>(newline - begin) + 1;
+        return true;
+      }
+      line.append(begin, end_ - begin_);
+      if (!fill()) {
+        return !line.empty();
+      }
+    }
+  }
+
+  void readExact(char* data, std::size_t size) override
+  {
+    auto buffered = std::min(size, end_ - begin_);
+    std::memcpy(data, buffer_.data() + begin_, buffered);
+    begin_ += buffered;
+    // Large inputs are read straight into the destination
+    for (std::size_t done = buffered; done < size;) {
+      auto count = readSome(data + done, size - done);
+      if (count == 0) {
+        throw std::runtime_error("Unexpected end of stream");
+      }
+      done += count;
+    }
+  }
+
+  void write(std::string_view data) override
+  {
+    while (!data.empty()) {
+      auto count = ::write(writeFd_, data.data(), data.size());
+      if (count < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        throw std::system_error(errno, std::generic_category(), "write");
+      }
+      data.remove_prefix(static_cast<std::size_t>(count));
+    }
+  }
+
+private:
+  bool fill()
+  {
+    begin_ = 0;
+    end_ = readSome(buffer_.data(), buffer_.size());
+    return end_ > 0;
+  }
+
+  std::size_t readSome(char* data, std::size_t size)
+  {
+    while (true) {
+      auto count = ::read(readFd_, data, size);
+      if (count >= 0) {
+        return static_cast<std::size_t>(count);
+      }
+      if (errno != EINTR) {
+        throw std::system_error(errno, std::generic_category(), "read");
+      }
+    }
+  }
+
+  int readFd_;
+  int writeFd_;
+  bool owning_;
+  std::vector<char> buffer_;
+  std::size_t begin_{};
+  std::size_t end_{};
+};
+
+inline sockaddr_un unixSocketAddress(const std::filesystem::path& path)
+{
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  const auto& native = path.native();
+  if (native.size() >= sizeof(address.sun_path)) {
+    throw std::runtime_error("Socket path too long: " + path.string());
+  }
+  std::memcpy(address.sun_path, native.c_str(), native.size() + 1);
+  return address;
+}
+
+inline int connectUnixSocket(const std::filesystem::path& path)
+{
+  int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) {
+    throw std::system_error(errno, std::generic_category(), "socket");
+  }
+  auto address = unixSocketAddress(path);
+  if (::connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+    int error = errno;
+    ::close(fd);
+    throw std::system_error(error, std::generic_category(), "connect to " + path.string());
+  }
+  return fd;
+}
+#endif
+
+// Keeps all solvers resident and answers requests from any number of connections. Requests are queued and run on
+// the WorkStealingPool the solvers use for their parallel loops; a worker takes the oldest request together with
+// queued requests for the same day (up to maxBatch), so a burst for one day runs back to back on warm caches.
+class SolverServer
+{
+public:
+  explicit SolverServer(std::size_t maxBatch = 16) : maxBatch_(std::max<std::size_t>(maxBatch, 1)) {}
+
+  SolverServer(const SolverServer&) = delete;
+  SolverServer& operator=(const SolverServer&) = delete;
+
+  // The pool outlives the server, jobs that are still queued have to be done before the queue goes away
+  ~SolverServer()
+  {
+    std::unique_lock lock(queueMutex_);
+    jobsDone_.wait(lock, [this] { return postedJobs_ == 0; });
+  }
+
+  // Reads requests until the connection ends, returns once all of its responses are written
+  void serve(Connection& connection)
+  {
+    ConnectionState state(connection);
+    std::string line;
+    try {
+      while (connection.readLine(line)) {
+        if (line.empty()) {
+          continue;
+        }
+        auto header = parseRequestHeader(line);
+        std::vector<char> input(header.size);
+        connection.readExact(input.data(), input.size());
+
+        const DaySolver* solver = findDaySolver(header.day);
+        if (solver == nullptr) {
+          respond(state, fmt::format("{} error Unknown day: {}\n", header.id, header.day));
+          continue;
+        }
+        enqueue({.id = header.id,
+                 .solver = solver,
+                 .tasks = header.tasks,
+                 .input = std::move(input),
+                 .received = Clock::now(),
+                 .state = &state});
+      }
+    } catch (const std::exception& e) {
+      // The frame boundary is lost, the rest of the connection is dropped
+      respond(state, fmt::format("0 error {}\n", e.what()));
+    }
+
+    std::unique_lock lock(state.mutex);
+    state.done.wait(lock, [&state] { return state.outstanding == 0; });
+  }
+
+#ifdef AOC_HAS_UNIX_SOCKETS
+  // Accepts connections until an error occurs, every connection is read on its own thread
+  void listen(const std::filesystem::path& socketPath)
+  {
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+      throw std::system_error(errno, std::generic_category(), "socket");
+    }
+    auto address = unixSocketAddress(socketPath);
+    ::unlink(socketPath.c_str());
+    if (::bind(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 ||
+        ::listen(fd, SOMAXCONN) != 0) {
+      int error = errno;
+      ::close(fd);
+      throw std::system_error(error, std::generic_category(), "listen on " + socketPath.string());
+    }
+
+    while (true) {
+      int client = ::accept(fd, nullptr, nullptr);
+      if (client < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        int error = errno;
+        ::close(fd);
+        throw std::system_error(error, std::generic_category(), "accept");
+      }
+      std::thread([this, client] {
+        FdConnection connection(client, client, true);
+        serve(connection);
+      }).detach();
+    }
+  }
+#endif
+
+  // Latency from receiving a request to having its response ready
+  std::string latencySummary() const
+  {
+    std::lock_guard lock(statsMutex_);
+    if (latencies_.empty()) {
+      return "no requests served";
+    }
+    auto sorted = latencies_;
+    std::sort(sorted.begin(), sorted.end());
+    auto percentile = [&sorted](double p) {
+      return sorted[static_cast<std::size_t>(p * static_cast<double>(sorted.size() - 1))];
+    };
+    return fmt::format("{} requests, latency median {} p99 {} max {}", sorted.size(), formatDuration(percentile(0.5)),
+                       formatDuration(percentile(0.99)), formatDuration(sorted.back()));
+  }
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  struct ConnectionState
+  {
+    explicit ConnectionState(Connection& connection) : connection(connection)
+    {
+    }
+
+    Connection& connection;
+    std::mutex writeMutex;
+    std::mutex mutex;
+    std::condition_variable done;
+    std::size_t outstanding{};
+  };
+
+  struct Request
+  {
+    uint64_t id{};
+    const DaySolver* solver{nullptr};
+    TaskSelection tasks;
+    std::vector<char> input;
+    Clock::time_point received;
+    ConnectionState* state{nullptr};
+  };
+
+  void enqueue(Request request)
+  {
+    {
+      std::lock_guard lock(request.state->mutex);
+      request.state->outstanding++;
+    }
+    {
+      std::lock_guard lock(queueMutex_);
+      queue_.push_back(std::move(request));
+      postedJobs_++;
+    }
+    // One job per request, a job finds the queue empty if an earlier batch already took its request
+    WorkStealingPool::global().post([this] {
+      processBatch();
+      std::lock_guard lock(queueMutex_);
+      postedJobs_--;
+      jobsDone_.notify_all();
+    });
+  }
+
+  void processBatch()
+  {
+    std::vector<Request> batch;
+    {
+      std::lock_guard lock(queueMutex_);
+      if (queue_.empty()) {
+        return;
+      }
+      const DaySolver* solver = queue_.front().solver;
+      for (auto it = queue_.begin(); it != queue_.end() && batch.size() < maxBatch_;) {
+        if (it->solver == solver) {
+          batch.push_back(std::move(*it));
+          it = queue_.erase(it);
+        } else {
+          ++it;
+        }
+      }
+    }
+    for (auto& request : batch) {
+      process(request);
+    }
+  }
+
+  void process(Request& request)
+  {
+    auto started = Clock::now();
+    std::string response;
+    try {
+      MappedInput input(std::move(request.input));
+      auto answers = request.solver->solve(input, request.tasks);
+      auto finished = Clock::now();
+      auto format = [](const std::optional<int64_t>& answer) {
+        return answer ? std::to_string(*answer) : std::string("-");
+      };
+      auto micros = [](Clock::duration duration) {
+        return std::chrono::duration<double, std::micro>(duration).count();
+      };
+      response = fmt::format("{} ok {} {} {:.1f} {:.1f}\n", request.id, format(answers.task1), format(answers.task2),
+                             micros(started - request.received), micros(finished - started));
+
+      std::lock_guard lock(statsMutex_);
+      latencies_.push_back(std::chrono::duration<double, std::nano>(finished - request.received).count());
+    } catch (const std::exception& e) {
+      response = fmt::format("{} error {}\n", request.id, e.what());
+    }
+    respond(*request.state, response);
+
+    std::lock_guard lock(request.state->mutex);
+    request.state->outstanding--;
+    request.state->done.notify_all();
+  }
+
+  static void respond(ConnectionState& state, std::string_view response)
+  {
+    std::lock_guard lock(state.writeMutex);
+    try {
+      state.connection.write(response);
+    } catch (const std::exception&) {
+      // The client went away, its remaining requests are still drained
+    }
+  }
+
+  std::size_t maxBatch_;
+  std::mutex queueMutex_;
+  std::deque<Request> queue_;
+  // Jobs posted to the pool but not finished yet, guarded by queueMutex_
+  std::size_t postedJobs_{0};
+  std::condition_variable jobsDone_;
+  mutable std::mutex statsMutex_;
+  std::vector<double> latencies_;
+};
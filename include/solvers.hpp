@@ -0,0 +1,94 @@
+#pragma once
+
+#include "mapped_input.hpp"
+
+#include <cstdint>
+#include <optional>
+
+// Interface between the days and the aoc runner. Every day lives in its own namespace and exposes a solve()
+// that parses the input once and computes the selected tasks.
+
+struct TaskSelection
+{
+  bool task1{true};
+  bool task2{true};
+};
+
+// A task that was not selected (or is not implemented for that day) has no value
+struct Answers
+{
+  std::optional<int64_t> task1;
+  std::optional<int64_t> task2;
+};
+
+using Solver = Answers (*)(const MappedInput& input, TaskSelection tasks);
+
+namespace day1
+{
+Answers solve(const MappedInput& input, TaskSelection tasks);
+}
+
+namespace day2
+{
+Answers solve(const MappedInput& input, TaskSelection tasks);
+}
+
+namespace day3
+{
+Answers solve(const MappedInput& input, TaskSelection tasks);
+}
+
+namespace day4
+{
+Answers solve(const MappedInput& input, TaskSelection tasks);
+}
+
+namespace day5
+{
+Answers solve(const MappedInput& input, TaskSelection tasks);
+}
+
+namespace day6
+{
+Answers solve(const MappedInput& input, TaskSelection tasks);
+}
+
+namespace day7
+{
+Answers solve(const MappedInput& input, TaskSelection tasks);
+}
+
+namespace day8
+{
+Answers solve(const MappedInput& input, TaskSelection tasks);
+}
+
+namespace day9
+{
+Answers solve(const MappedInput& input, TaskSelection tasks);
+}
+
+namespace day10
+{
+Answers solve(const MappedInput& input, TaskSelection tasks);
+}
+
+namespace day11
+{
+Answers solve(const MappedInput& input, TaskSelection tasks);
+}
+
+namespace day12
+{
+Answers solve(const MappedInput& input, TaskSelection tasks);
+}
+
+namespace day13
+{
+Answers solve(const MappedInput& input, TaskSelection tasks);
+}
+
+namespace day15
+{
+Answers solve(const MappedInput& input, TaskSelection tasks);
+}
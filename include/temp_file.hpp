@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+// Uniquely named path in the temp directory for test inputs. The file is removed when the object goes out of scope,
+// so it does not stay behind if a REQUIRE fails, and concurrent test runs do not write to the same file.
+class TempFile
+{
+public:
+  explicit TempFile(std::string_view prefix)
+  {
+    std::random_device device;
+    std::uniform_int_distribution<std::uint64_t> distribution;
+    auto directory = std::filesystem::temp_directory_path();
+    do {
+      path_ = directory / (std::string(prefix) + "_" + std::to_string(distribution(device)) + ".txt");
+    } while (std::filesystem::exists(path_));
+  }
+
+  TempFile(const TempFile&) = delete;
+  TempFile& operator=(const TempFile&) = delete;
+
+  ~TempFile()
+  {
+    std::error_code error;
+    std::filesystem::remove(path_, error);
+  }
+
+  const std::filesystem::path& path() const
+  {
+    return path_;
+  }
+
+private:
+  std::filesystem::path path_;
+};
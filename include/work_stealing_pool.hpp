@@ -0,0 +1,248 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Thread pool for data parallel loops. Every worker owns a job deque: it pushes and pops its own jobs at the back,
+// which keeps recently touched data in its cache, and steals from the front of the other deques once its own runs
+// dry. Jobs posted from outside are spread round robin over the deques.
+//
+// forEachChunk() hands the chunks of a loop out through one shared counter, the calling thread works along, so a
+// loop finishes even if every worker is busy elsewhere (e.g. in an outer loop on the same pool). Outer work like the
+// days of the aoc runner is submitted to the same pool instead of a second one, so nested loops never run on more
+// threads than the pool has.
+class WorkStealingPool
+{
+public:
+  explicit WorkStealingPool(std::size_t threadCount = defaultThreadCount())
+  {
+    threadCount = std::max<std::size_t>(threadCount, 1);
+    queues_.reserve(threadCount);
+    for (std::size_t i = 0; i < threadCount; i++) {
+      queues_.push_back(std::make_unique<Queue>());
+    }
+    workers_.reserve(threadCount);
+    for (std::size_t i = 0; i < threadCount; i++) {
+      workers_.emplace_back([this, i](std::stop_token stop) { workerLoop(stop, i); });
+    }
+  }
+
+  WorkStealingPool(const WorkStealingPool&) = delete;
+  WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+  ~WorkStealingPool()
+  {
+    for (auto& worker : workers_) {
+      worker.request_stop();
+    }
+  }
+
+  // The calling thread takes part in every loop, so one thread less than there are cores
+  static std::size_t defaultThreadCount()
+  {
+    return std::max(std::thread::hardware_concurrency(), 2U) - 1;
+  }
+
+  // Shared by all solvers, started on first use
+  static WorkStealingPool& global()
+  {
+    static WorkStealingPool pool(globalThreadCount_ > 0 ? globalThreadCount_.load() : defaultThreadCount());
+    return pool;
+  }
+
+  // Worker count of global(), only has an effect before its first use (aoc --threads)
+  static void setGlobalThreadCount(std::size_t threadCount)
+  {
+    globalThreadCount_ = threadCount;
+  }
+
+  std::size_t size() const
+  {
+    return workers_.size();
+  }
+
+  template<class Fn>
+  std::future<std::invoke_result_t<Fn>> submit(Fn&& fn)
+  {
+    using Result = std::invoke_result_t<Fn>;
+    // std::function needs a copyable target, the packaged_task is shared instead
+    auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<Fn>(fn));
+    auto future = task->get_future();
+    post([task] { (*task)(); });
+    return future;
+  }
+
+  // Fire and forget, fn must not throw
+  template<class Fn>
+  void post(Fn&& fn)
+  {
+    auto index =
+        currentPool_ == this ? currentIndex_ : nextQueue_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+    {
+      std::lock_guard lock(queues_[index]->mutex);
+      queues_[index]->jobs.emplace_back(std::forward<Fn>(fn));
+    }
+    {
+      std::lock_guard lock(sleepMutex_);
+      pending_++;
+    }
+    jobAvailable_.notify_one();
+  }
+
+  // Calls fn(begin, end) for the chunks [0, chunkSize), [chunkSize, 2 * chunkSize), ... of [0, count) and returns
+  // once all of them are done. The first exception thrown by fn is rethrown here, chunks that did not start by then
+  // are skipped.
+  template<class Fn>
+  void forEachChunk(std::size_t count, std::size_t chunkSize, Fn&& fn)
+  {
+    chunkSize = std::max<std::size_t>(chunkSize, 1);
+    const std::size_t chunkCount = (count + chunkSize - 1) / chunkSize;
+    if (chunkCount <= 1) {
+      if (count > 0) {
+        fn(std::size_t{0}, count);
+      }
+      return;
+    }
+
+    // Helpers may only get to run after the loop is over, everything they touch is kept alive by them
+    struct Loop
+    {
+      std::size_t count;
+      std::size_t chunkSize;
+      std::size_t chunkCount;
+      std::atomic<std::size_t> nextChunk{0};
+      std::atomic<std::size_t> finishedChunks{0};
+      std::atomic<bool> failed{false};
+      std::exception_ptr error;
+      std::mutex mutex;
+      std::condition_variable done;
+      std::function<void(std::size_t, std::size_t)> body;
+
+      // Returns once there is no chunk left to claim
+      void work()
+      {
+        std::size_t finished = 0;
+        for (auto chunk = nextChunk.fetch_add(1); chunk < chunkCount; chunk = nextChunk.fetch_add(1)) {
+          if (!failed.load(std::memory_order_relaxed)) {
+            try {
+              auto begin = chunk * chunkSize;
+              body(begin, std::min(begin + chunkSize, count));
+            } catch (...) {
+              std::lock_guard lock(mutex);
+              if (!error) {
+                error = std::current_exception();
+              }
+              failed = true;
+            }
+          }
+          finished++;
+        }
+        if (finished > 0 && finishedChunks.fetch_add(finished) + finished == chunkCount) {
+          std::lock_guard lock(mutex);
+          done.notify_all();
+        }
+      }
+    };
+
+    auto loop = std::make_shared<Loop>();
+    loop->count = count;
+    loop->chunkSize = chunkSize;
+    loop->chunkCount = chunkCount;
+    loop->body = std::ref(fn);
+
+    const auto helpers = std::min(size(), chunkCount - 1);
+    for (std::size_t i = 0; i < helpers; i++) {
+      post([loop] { loop->work(); });
+    }
+    loop->work();
+    {
+      std::unique_lock lock(loop->mutex);
+      loop->done.wait(lock, [&loop] { return loop->finishedChunks.load() == loop->chunkCount; });
+    }
+    if (loop->error) {
+      std::rethrow_exception(loop->error);
+    }
+  }
+
+private:
+  struct Queue
+  {
+    std::mutex mutex;
+    std::deque<std::function<void()>> jobs;
+  };
+
+  bool popOwn(std::size_t index, std::function<void()>& job)
+  {
+    auto& queue = *queues_[index];
+    std::lock_guard lock(queue.mutex);
+    if (queue.jobs.empty()) {
+      return false;
+    }
+    job = std::move(queue.jobs.back());
+    queue.jobs.pop_back();
+    return true;
+  }
+
+  bool steal(std::size_t thief, std::function<void()>& job)
+  {
+    for (std::size_t offset = 1; offset < queues_.size(); offset++) {
+      auto& queue = *queues_[(thief + offset) % queues_.size()];
+      std::lock_guard lock(queue.mutex);
+      if (!queue.jobs.empty()) {
+        job = std::move(queue.jobs.front());
+        queue.jobs.pop_front();
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void workerLoop(std::stop_token stop, std::size_t index)
+  {
+    currentPool_ = this;
+    currentIndex_ = index;
+    while (true) {
+      std::function<void()> job;
+      if (popOwn(index, job) || steal(index, job)) {
+        {
+          std::lock_guard lock(sleepMutex_);
+          pending_--;
+        }
+        job();
+        continue;
+      }
+      // Queued jobs are finished before a stopped pool shuts down
+      std::unique_lock lock(sleepMutex_);
+      if (!jobAvailable_.wait(lock, stop, [this] { return pending_ > 0; })) {
+        return;
+      }
+    }
+  }
+
+  // Worker the calling thread belongs to, posts from a worker go to its own deque
+  static inline thread_local const WorkStealingPool* currentPool_{nullptr};
+  static inline thread_local std::size_t currentIndex_{0};
+  static inline std::atomic<std::size_t> globalThreadCount_{0};
+
+  std::vector<std::unique_ptr<Queue>> queues_;
+  std::atomic<std::size_t> nextQueue_{0};
+  std::mutex sleepMutex_;
+  std::condition_variable_any jobAvailable_;
+  // Jobs posted but not yet taken, guarded by sleepMutex_
+  std::size_t pending_{0};
+  // Declared last so the workers are joined before the queues are destroyed
+  std::vector<std::jthread> workers_;
+};
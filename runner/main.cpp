@@ -0,0 +1,332 @@
+#include "bench.hpp"
+#include "mapped_input.hpp"
+#include "profile.hpp"
+#include "solver_registry.hpp"
+#include "solver_server.hpp"
+#include "solvers.hpp"
+#include "work_stealing_pool.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <exception>
+#include <filesystem>
+#include <fmt/core.h>
+#include <future>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+struct Job
+{
+  const DaySolver* solver{nullptr};
+  std::filesystem::path input;
+};
+
+enum class Mode
+{
+  Run,
+  Serve,
+  Client,
+};
+
+struct Options
+{
+  Mode mode{Mode::Run};
+  // Socket path of --serve/--client, "-" for stdin/stdout
+  std::string endpoint;
+  std::vector<Job> jobs;
+  TaskSelection tasks;
+  std::size_t threads{std::max(std::thread::hardware_concurrency(), 1U)};
+  std::size_t batch{16};
+  std::size_t repeat{1};
+  std::optional<std::filesystem::path> trace;
+};
+
+struct JobResult
+{
+  Answers answers;
+  std::chrono::duration<double, std::nano> readTime{};
+  std::chrono::duration<double, std::nano> solveTime{};
+};
+
+void printUsage()
+{
+  fmt::println("Usage: aoc [options] [day[=input] ...]");
+  fmt::println("       aoc --serve <socket|-> [--threads N] [--batch N]");
+  fmt::println("       aoc --client <socket|-> [--repeat N] [options] [day[=input] ...]");
+  fmt::println("  day                dayN or N, all days are run if none is given");
+  fmt::println("  day=input          input file of that day, defaults to <day>/input.txt");
+  fmt::println("Options:");
+  fmt::println("  --tasks 1|2|both   tasks to run (default both)");
+  fmt::println("  --threads N        number of worker threads (default hardware concurrency)");
+  fmt::println("  --input-dir DIR    read <DIR>/<day>.txt, e.g. inputs written by aoc_gen");
+  fmt::println("  --serve ENDPOINT   keep the solvers resident and answer requests, see include/solver_server.hpp");
+  fmt::println("  --batch N          requests of the same day a server worker takes at once (default 16)");
+  fmt::println("  --client ENDPOINT  send the selected days to a server and print the responses, with '-' the");
+  fmt::println("                     requests are written to stdout, e.g. aoc --client - | aoc --serve -");
+  fmt::println("  --repeat N         send every request N times (default 1)");
+  fmt::println("  --trace FILE       write a Chrome trace of the run, needs a build with -DAOC_PROFILE=ON");
+}
+
+std::optional<Options> parseArguments(int argc, char** argv)
+{
+  Options options;
+  std::optional<std::filesystem::path> inputDir;
+  std::vector<std::string_view> selected;
+
+  for (int i = 1; i < argc; i++) {
+    std::string_view arg = argv[i];
+    if (arg == "--help" || arg == "-h") {
+      return std::nullopt;
+    }
+    if (arg == "--tasks" || arg == "--threads" || arg == "--input-dir" || arg == "--serve" || arg == "--client" ||
+        arg == "--batch" || arg == "--repeat" || arg == "--trace") {
+      if (i + 1 == argc) {
+        throw std::runtime_error(fmt::format("Missing value for {}", arg));
+      }
+      std::string_view value = argv[++i];
+      if (arg == "--tasks") {
+        if (value != "1" && value != "2" && value != "both") {
+          throw std::runtime_error(fmt::format("Invalid tasks: {}", value));
+        }
+        options.tasks = {.task1 = value != "2", .task2 = value != "1"};
+      } else if (arg == "--threads") {
+        options.threads = std::stoull(std::string(value));
+      } else if (arg == "--batch") {
+        options.batch = std::stoull(std::string(value));
+      } else if (arg == "--repeat") {
+        options.repeat = std::stoull(std::string(value));
+      } else if (arg == "--trace") {
+        options.trace = value;
+      } else if (arg == "--input-dir") {
+        inputDir = value;
+      } else {
+        options.mode = arg == "--serve" ? Mode::Serve : Mode::Client;
+        options.endpoint = value;
+      }
+      continue;
+    }
+    selected.push_back(arg);
+  }
+
+  auto defaultInput = [&inputDir](std::string_view day) {
+    if (inputDir) {
+      return *inputDir / (std::string(day) + ".txt");
+    }
+    return std::filesystem::path(day) / "input.txt";
+  };
+
+  if (selected.empty()) {
+    for (const auto& solver : daySolvers) {
+      options.jobs.push_back({.solver = &solver, .input = defaultInput(solver.day)});
+    }
+    return options;
+  }
+
+  for (auto arg : selected) {
+    auto separator = arg.find('=');
+    auto name = arg.substr(0, separator);
+    const DaySolver* solver = findDaySolver(name);
+    if (solver == nullptr) {
+      throw std::runtime_error(fmt::format("Unknown day: {}", name));
+    }
+    auto input = separator == std::string_view::npos ? defaultInput(solver->day)
+                                                     : std::filesystem::path(arg.substr(separator + 1));
+    options.jobs.push_back({.solver = solver, .input = std::move(input)});
+  }
+  return options;
+}
+
+JobResult runJob(const Job& job, TaskSelection tasks)
+{
+  AOC_PROFILE_ZONE(job.solver->day);
+  JobResult result;
+  auto start = Clock::now();
+  auto input = [&job] {
+    AOC_PROFILE_ZONE("read");
+    return MappedInput(job.input);
+  }();
+  auto mapped = Clock::now();
+  result.answers = job.solver->solve(input, tasks);
+  result.readTime = mapped - start;
+  result.solveTime = Clock::now() - mapped;
+  return result;
+}
+
+std::string formatAnswer(const std::optional<int64_t>& answer)
+{
+  return answer ? std::to_string(*answer) : std::string("-");
+}
+
+int runServer(const Options& options)
+{
+  WorkStealingPool::setGlobalThreadCount(options.threads);
+  SolverServer server(options.batch);
+  if (options.endpoint == "-") {
+#ifdef AOC_HAS_UNIX_SOCKETS
+    FdConnection connection(STDIN_FILENO, STDOUT_FILENO);
+#else
+    StreamConnection connection(std::cin, std::cout);
+#endif
+    server.serve(connection);
+    fmt::print(stderr, "{}\n", server.latencySummary());
+    if (options.trace) {
+      profile::writeChromeTrace(*options.trace);
+    }
+    return 0;
+  }
+
+#ifdef AOC_HAS_UNIX_SOCKETS
+  // A client closing its socket early must not kill the server
+  std::signal(SIGPIPE, SIG_IGN);
+  fmt::print(stderr, "Listening on {} with {} threads\n", options.endpoint, options.threads);
+  server.listen(options.endpoint);
+  return 0;
+#else
+  fmt::println("Error: Unix domain sockets are not supported on this platform, use --serve -");
+  return 1;
+#endif
+}
+
+// Stand-in for a real client: pipelines all requests, then prints the responses together with the round trip time
+int runClient(const Options& options)
+{
+  // Inputs are read up front so the round trip does not include disk reads
+  std::vector<std::string> inputs;
+  for (const auto& job : options.jobs) {
+    MappedInput input(job.input);
+    inputs.emplace_back(input.data());
+  }
+
+  auto sendRequests = [&options, &inputs](Connection& connection, std::vector<Clock::time_point>& sent) {
+    for (std::size_t i = 0; i < options.repeat * options.jobs.size(); i++) {
+      std::size_t job = i % options.jobs.size();
+      sent.push_back(Clock::now());
+      connection.write(formatRequestHeader(i, options.jobs[job].solver->day, options.tasks, inputs[job].size()));
+      connection.write(inputs[job]);
+    }
+  };
+
+  std::vector<Clock::time_point> sent;
+  if (options.endpoint == "-") {
+    StreamConnection connection(std::cin, std::cout);
+    sendRequests(connection, sent);
+    return 0;
+  }
+
+#ifdef AOC_HAS_UNIX_SOCKETS
+  int fd = connectUnixSocket(options.endpoint);
+  FdConnection connection(fd, fd, true);
+  sendRequests(connection, sent);
+  ::shutdown(fd, SHUT_WR);
+
+  int exitCode = 0;
+  std::string line;
+  for (std::size_t received = 0; received < sent.size() && connection.readLine(line); received++) {
+    auto now = Clock::now();
+    auto words = splitWords(line);
+    auto id = words.empty() ? std::nullopt : parseNumber<std::size_t>(words[0]);
+    if (!id || *id >= sent.size() || words.size() < 2 || words[1] != "ok") {
+      exitCode = 1;
+      fmt::println("{}", line);
+      continue;
+    }
+    std::chrono::duration<double, std::nano> roundTrip = now - sent[*id];
+    fmt::println("{:<6} {:<40} round trip {:>12}", options.jobs[*id % options.jobs.size()].solver->day, line,
+                 formatDuration(roundTrip.count()));
+  }
+  return exitCode;
+#else
+  fmt::println("Error: Unix domain sockets are not supported on this platform, use --client -");
+  return 1;
+#endif
+}
+}  // namespace
+
+int main(int argc, char** argv)
+{
+  std::optional<Options> options;
+  try {
+    options = parseArguments(argc, argv);
+  } catch (const std::exception& e) {
+    fmt::println("Error: {}", e.what());
+    printUsage();
+    return 1;
+  }
+  if (!options) {
+    printUsage();
+    return 0;
+  }
+
+  if (options->trace) {
+    if (!profile::compiledIn) {
+      fmt::print(stderr, "Warning: built without AOC_PROFILE, the trace only contains thread names\n");
+    }
+    profile::enable();
+    profile::setThreadName("main");
+  }
+
+  try {
+    if (options->mode == Mode::Serve) {
+      return runServer(*options);
+    }
+    if (options->mode == Mode::Client) {
+      return runClient(*options);
+    }
+  } catch (const std::exception& e) {
+    fmt::print(stderr, "Error: {}\n", e.what());
+    return 1;
+  }
+
+  auto start = Clock::now();
+  std::vector<std::future<JobResult>> results;
+  results.reserve(options->jobs.size());
+  // The days run on the pool their parallel loops use, the main thread only waits for the results
+  WorkStealingPool::setGlobalThreadCount(options->threads);
+  auto& pool = WorkStealingPool::global();
+  for (const auto& job : options->jobs) {
+    results.push_back(pool.submit([&job, tasks = options->tasks] { return runJob(job, tasks); }));
+  }
+
+  // Results are printed in the requested order, the days still run concurrently
+  int exitCode = 0;
+  std::chrono::duration<double, std::nano> cpuTime{};
+  for (std::size_t i = 0; i < results.size(); i++) {
+    const auto& job = options->jobs[i];
+    try {
+      auto result = results[i].get();
+      cpuTime += result.readTime + result.solveTime;
+      fmt::println("{:<6} task1 {:>20} task2 {:>20}   read {:>12} solve {:>12}", job.solver->day,
+                   formatAnswer(result.answers.task1), formatAnswer(result.answers.task2),
+                   formatDuration(result.readTime.count()), formatDuration(result.solveTime.count()));
+    } catch (const std::exception& e) {
+      exitCode = 1;
+      fmt::println("{:<6} failed: {}", job.solver->day, e.what());
+    }
+  }
+
+  std::chrono::duration<double, std::nano> wallTime = Clock::now() - start;
+  fmt::println("{} days on {} threads: wall {}, sum of days {}", options->jobs.size(), pool.size(),
+               formatDuration(wallTime.count()), formatDuration(cpuTime.count()));
+  if (options->trace) {
+    try {
+      profile::writeChromeTrace(*options->trace);
+    } catch (const std::exception& e) {
+      fmt::print(stderr, "Error: {}\n", e.what());
+      exitCode = 1;
+    }
+  }
+  return exitCode;
+}